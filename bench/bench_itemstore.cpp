@@ -0,0 +1,165 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "fixtures.h"
+#include "itemstore.h"
+#include "memory.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTemporaryDir>
+#include <QTest>
+using namespace Qt::StringLiterals;
+using namespace github;
+using namespace std;
+
+static const int issue_count = 5000;
+
+// The QJsonDocument based storage the binary layout is compared with
+
+static QJsonObject toJson(const IssueItem::Data &d)
+{
+    QJsonArray reactions;
+    for (const auto count : d.reactions)
+        reactions.append(count);
+
+    return {{u"repository"_s, d.repository},
+            {u"node_id"_s, d.node_id},
+            {u"number"_s, d.number},
+            {u"title"_s, d.title},
+            {u"state"_s, d.state},
+            {u"html_url"_s, d.html_url},
+            {u"avatar_url"_s, d.avatar_url},
+            {u"updated_at"_s, d.updated_at},
+            {u"labels"_s, QJsonArray::fromStringList(d.labels)},
+            {u"reactions"_s, reactions},
+            {u"pull_request"_s, d.pull_request}};
+}
+
+static IssueItem::Data fromJson(const QJsonObject &o)
+{
+    IssueItem::Data d{.repository = o["repository"_L1].toString(),
+                      .node_id = o["node_id"_L1].toString(),
+                      .number = o["number"_L1].toInteger(),
+                      .title = o["title"_L1].toString(),
+                      .state = o["state"_L1].toString(),
+                      .html_url = o["html_url"_L1].toString(),
+                      .avatar_url = o["avatar_url"_L1].toString(),
+                      .updated_at = o["updated_at"_L1].toString(),
+                      .pull_request = o["pull_request"_L1].toBool()};
+    for (const auto &label : o["labels"_L1].toArray())
+        d.labels << label.toString();
+    const auto reactions = o["reactions"_L1].toArray();
+    for (size_t r = 0; r < d.reactions.size(); ++r)
+        d.reactions[r] = reactions[static_cast<qsizetype>(r)].toInteger();
+    return d;
+}
+
+static vector<IssueItem::Data> loadJson(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+
+    vector<IssueItem::Data> issues;
+    for (const auto &value : QJsonDocument::fromJson(file.readAll()).array())
+        issues.push_back(fromJson(value.toObject()));
+    return issues;
+}
+
+///
+/// Compares the memory-mapped ItemStore with QJsonDocument based storage of 5000 issues.
+///
+/// Loading is what a query needs to match the issues: the titles of all records.
+///
+class ItemStoreBenchmark : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir dir_;
+    QString store_path_;
+    QString json_path_;
+
+private slots:
+
+    void initTestCase()
+    {
+        QVERIFY(dir_.isValid());
+        store_path_ = dir_.filePath(u"issues.bin"_s);
+        json_path_ = dir_.filePath(u"issues.json"_s);
+
+        const auto page = QJsonDocument::fromJson(fixtures::issues(issue_count, true));
+        ItemStore::Writer writer;
+        QJsonArray array;
+        for (const auto &value : page["items"_L1].toArray())
+        {
+            const auto d = IssueItem::dataFromJson(value.toObject());
+            writer.add(d);
+            array.append(toJson(d));
+        }
+        QVERIFY(writer.write(store_path_));
+
+        QSaveFile file(json_path_);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QJsonDocument(array).toJson(QJsonDocument::Compact));
+        QVERIFY(file.commit());
+    }
+
+    void loadItemStore()
+    {
+        QBENCHMARK {
+            const auto store = ItemStore::open(store_path_);
+            qsizetype size = 0;
+            for (size_t i = 0; i < store->size(); ++i)
+                size += store->string(i, ItemStore::IssueFields::Title).size();
+            QVERIFY(size > 0);
+        }
+    }
+
+    void loadJson()
+    {
+        QBENCHMARK {
+            const auto issues = ::loadJson(json_path_);
+            qsizetype size = 0;
+            for (const auto &d : issues)
+                size += d.title.size();
+            QVERIFY(size > 0);
+        }
+    }
+
+    // Resident memory growth while the loaded issues are held
+
+    void rssItemStore()
+    {
+        if (memory::currentRss() == 0)
+            QSKIP("Resident memory is unknown on this platform");
+
+        const auto before = memory::currentRss();
+        const auto store = ItemStore::open(store_path_);
+        qsizetype size = 0;
+        for (size_t i = 0; i < store->size(); ++i)
+            size += store->string(i, ItemStore::IssueFields::Title).size();
+        QVERIFY(size > 0);
+
+        // Includes the touched pages of the mapping, which are clean and shared
+        QTest::setBenchmarkResult((qreal(memory::currentRss()) - qreal(before)) * 1024,
+                                  QTest::BytesAllocated);
+    }
+
+    void rssJson()
+    {
+        if (memory::currentRss() == 0)
+            QSKIP("Resident memory is unknown on this platform");
+
+        const auto before = memory::currentRss();
+        const auto issues = ::loadJson(json_path_);
+        QCOMPARE(issues.size(), size_t(issue_count));
+
+        QTest::setBenchmarkResult((qreal(memory::currentRss()) - qreal(before)) * 1024,
+                                  QTest::BytesAllocated);
+    }
+};
+
+QTEST_GUILESS_MAIN(ItemStoreBenchmark)
+#include "bench_itemstore.moc"
@@ -0,0 +1,180 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "fixtures.h"
+#include "github.h"
+#include "items.h"
+#include "memory.h"
+#if defined(GITHUB_USE_SIMDJSON)
+#include "simdjsonparser.h"
+#endif
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTest>
+using namespace Qt::StringLiterals;
+using namespace github;
+using namespace std;
+
+enum class Type { User, Repository, Issue };
+Q_DECLARE_METATYPE(Type)
+
+static shared_ptr<GitHubItem> build(Type type, const QJsonObject &o)
+{
+    switch (type) {
+    case Type::User: return UserItem::fromJson(o);
+    case Type::Repository: return RepositoryItem::fromJson(o);
+    case Type::Issue: return IssueItem::fromJson(o);
+    }
+    return {};
+}
+
+static QJsonArray parseItems(const QByteArray &json)
+{
+    const auto var = RestApi::parseJson(Response{.status = 200, .body = json});
+    return get<QJsonDocument>(var)["items"_L1].toArray();
+}
+
+///
+/// Benchmarks the hot path of every search page: parsing the response and building the items.
+///
+/// Items are released after each iteration, i.e. each iteration builds new live items like a
+/// page of unseen results does.
+///
+class ParsingBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void parseJson_data() { addFixtures(); }
+    void parseJson()
+    {
+        QFETCH(QByteArray, json);
+        const Response response{.status = 200, .body = json};
+        QVERIFY(holds_alternative<QJsonDocument>(RestApi::parseJson(response)));
+
+        QBENCHMARK { auto var = RestApi::parseJson(response); }
+    }
+
+    void buildItems_data() { addFixtures(); }
+    void buildItems()
+    {
+        QFETCH(Type, type);
+        QFETCH(QByteArray, json);
+        const auto array = parseItems(json);
+
+        QBENCHMARK {
+            vector<shared_ptr<GitHubItem>> items;
+            items.reserve(array.size());
+            for (const auto &value : array)
+                items.push_back(build(type, value.toObject()));
+        }
+    }
+
+    void parseAllocationsPerItem_data() { addFixtures(); }
+    void parseAllocationsPerItem()
+    {
+        QFETCH(int, count);
+        QFETCH(QByteArray, json);
+        const Response response{.status = 200, .body = json};
+
+        const auto before = memory::allocations();
+        auto var = RestApi::parseJson(response);
+        const auto allocations = memory::allocations() - before;
+
+        QTest::setBenchmarkResult(qreal(allocations) / count, QTest::Events);
+    }
+
+    void buildAllocationsPerItem_data() { addFixtures(); }
+    void buildAllocationsPerItem()
+    {
+        QFETCH(Type, type);
+        QFETCH(int, count);
+        QFETCH(QByteArray, json);
+        const auto array = parseItems(json);
+
+        vector<shared_ptr<GitHubItem>> items;
+        items.reserve(array.size());
+        const auto before = memory::allocations();
+        for (const auto &value : array)
+            items.push_back(build(type, value.toObject()));
+        const auto allocations = memory::allocations() - before;
+
+        QTest::setBenchmarkResult(qreal(allocations) / count, QTest::Events);
+    }
+
+    // The backends compared on 100-item pages, parsing and building together
+
+    void pageQJsonDocument_data() { addPageFixtures(); }
+    void pageQJsonDocument()
+    {
+        QFETCH(Type, type);
+        QFETCH(QByteArray, json);
+
+        QBENCHMARK {
+            vector<shared_ptr<GitHubItem>> items;
+            for (const auto &value : parseItems(json))
+                items.push_back(build(type, value.toObject()));
+        }
+    }
+
+    void pageSimdjson_data() { addPageFixtures(); }
+    void pageSimdjson()
+    {
+#if defined(GITHUB_USE_SIMDJSON)
+        QFETCH(Type, type);
+        QFETCH(QByteArray, json);
+
+        const auto parse = [&]{
+            switch (type) {
+            case Type::User: return simd::parseSearchPage<UserItem>(json);
+            case Type::Repository: return simd::parseSearchPage<RepositoryItem>(json);
+            case Type::Issue: return simd::parseSearchPage<IssueItem>(json);
+            }
+            return variant<SearchPage, QString>(u"Invalid type"_s);
+        };
+        QVERIFY(holds_alternative<SearchPage>(parse()));
+
+        QBENCHMARK { auto page = parse(); }
+#else
+        QSKIP("Built without GITHUB_USE_SIMDJSON");
+#endif
+    }
+
+private:
+
+    static void addPageFixtures()
+    {
+        QTest::addColumn<Type>("type");
+        QTest::addColumn<QByteArray>("json");
+        QTest::addRow("users") << Type::User << fixtures::users(100);
+        QTest::addRow("repositories") << Type::Repository << fixtures::repositories(100);
+        QTest::addRow("repositories, long descriptions")
+            << Type::Repository << fixtures::repositories(100, 2000);
+        QTest::addRow("issues") << Type::Issue << fixtures::issues(100);
+        QTest::addRow("issues, reaction heavy") << Type::Issue << fixtures::issues(100, true);
+    }
+
+    static void addFixtures()
+    {
+        QTest::addColumn<Type>("type");
+        QTest::addColumn<int>("count");
+        QTest::addColumn<QByteArray>("json");
+
+        for (const auto count : {10, 100, 1000})
+        {
+            QTest::addRow("users %d", count) << Type::User << count << fixtures::users(count);
+            QTest::addRow("repositories %d", count)
+                << Type::Repository << count << fixtures::repositories(count);
+            QTest::addRow("issues %d", count) << Type::Issue << count << fixtures::issues(count);
+        }
+
+        QTest::addRow("repositories 100, long descriptions")
+            << Type::Repository << 100 << fixtures::repositories(100, 2000);
+        QTest::addRow("issues 100, reaction heavy")
+            << Type::Issue << 100 << fixtures::issues(100, true);
+    }
+};
+
+QTEST_GUILESS_MAIN(ParsingBenchmark)
+#include "bench_parsing.moc"
@@ -0,0 +1,98 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "fixtures.h"
+#include "github.h"
+#include "items.h"
+#include "memory.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTest>
+using namespace Qt::StringLiterals;
+using namespace github;
+using namespace std;
+
+static const int issue_count = 5000;
+static const int page_size = 100;
+static const int visible_rows = 10;
+
+///
+/// Stress test of an infinite scroll session over 5000 reaction heavy issues.
+///
+/// Each page is parsed, built and appended to the result list, which holds all items like the
+/// one of the frontend does. The rows of each page are rendered while scrolling down, then the
+/// first rows again after scrolling back to the top.
+///
+/// The peak resident set size is the one of the process. Run the rows separately for comparable
+/// peaks, e.g. `bench_scroll "scroll:compacted"`.
+///
+class ScrollBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void scroll_data()
+    {
+        QTest::addColumn<int>("window");
+        QTest::addRow("compacted") << 500;  // max_query_items of the search handlers
+        QTest::addRow("uncompacted") << issue_count;
+    }
+
+    void scroll()
+    {
+        QFETCH(int, window);
+
+        vector<QByteArray> pages;
+        {
+            const auto issues = QJsonDocument::fromJson(fixtures::issues(issue_count, true));
+            QJsonArray page;
+            for (const auto &value : issues["items"_L1].toArray())
+            {
+                page.append(value);
+                if (page.size() == page_size)
+                {
+                    pages.push_back(QJsonDocument(QJsonObject{{u"items"_s, page}})
+                                        .toJson(QJsonDocument::Compact));
+                    page = QJsonArray();
+                }
+            }
+        }
+
+        const auto rss_before = memory::currentRss();
+        ScrollWindow scroll_window(static_cast<size_t>(window));
+        vector<shared_ptr<GitHubItem>> results;
+        qsizetype rendered = 0;
+
+        for (const auto &json : pages)
+        {
+            const auto var = RestApi::parseJson(Response{.status = 200, .body = json});
+            QVERIFY(holds_alternative<QJsonDocument>(var));
+            for (const auto &value : get<QJsonDocument>(var)["items"_L1].toArray())
+            {
+                auto item = IssueItem::fromJson(value.toObject());
+                scroll_window.push(item);
+                rendered += item->text().size() + item->subtext().size();
+                results.push_back(::move(item));
+            }
+        }
+
+        for (int row = 0; row < visible_rows; ++row)  // back to the top, rehydrates
+            rendered += results[row]->subtext().size();
+
+        QVERIFY(rendered > 0);
+        QCOMPARE(results.size(), size_t(issue_count));
+        QCOMPARE(scroll_window.compacted(), size_t(issue_count - min(window, issue_count)));
+
+        qInfo().noquote() << u"%1 items alive, %2 compacted, resident %3 KiB → %4 KiB"_s
+                                 .arg(GitHubItem::liveCount())
+                                 .arg(scroll_window.compacted())
+                                 .arg(rss_before)
+                                 .arg(memory::currentRss());
+
+        QTest::setBenchmarkResult(qreal(memory::peakRss()) * 1024, QTest::BytesAllocated);
+    }
+};
+
+QTEST_GUILESS_MAIN(ScrollBenchmark)
+#include "bench_scroll.moc"
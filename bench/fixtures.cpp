@@ -0,0 +1,166 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "fixtures.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QString>
+using namespace Qt::StringLiterals;
+
+namespace
+{
+
+static const auto api = u"https://api.github.com"_s;
+
+QString text(int length, int seed)
+{
+    static const auto words = u"albert launcher query handler github search result item "
+                              "parser плагин 検索 ✨ performance pagination cache index"_s
+                                  .split(u' ');
+    QString s;
+    for (int i = seed; s.size() < length; ++i)
+        s += words[i % words.size()] + u' ';
+    s.truncate(length);
+    return s;
+}
+
+QJsonObject user(int i)
+{
+    const auto login = u"user%1"_s.arg(i);
+    return {
+        {u"login"_s, login},
+        {u"id"_s, 1000 + i},
+        {u"node_id"_s, u"MDQ6VXNlcj%1"_s.arg(i)},
+        {u"avatar_url"_s, u"https://avatars.githubusercontent.com/u/%1?v=4"_s.arg(1000 + i)},
+        {u"gravatar_id"_s, u""_s},
+        {u"url"_s, u"%1/users/%2"_s.arg(api, login)},
+        {u"html_url"_s, u"https://github.com/%1"_s.arg(login)},
+        {u"followers_url"_s, u"%1/users/%2/followers"_s.arg(api, login)},
+        {u"repos_url"_s, u"%1/users/%2/repos"_s.arg(api, login)},
+        {u"events_url"_s, u"%1/users/%2/events{/privacy}"_s.arg(api, login)},
+        {u"type"_s, i % 5 ? u"User"_s : u"Organization"_s},
+        {u"user_view_type"_s, u"public"_s},
+        {u"site_admin"_s, false},
+        {u"score"_s, 1.0}
+    };
+}
+
+QJsonObject repository(int i, int description_length)
+{
+    const auto full_name = u"user%1/repository-%2"_s.arg(i % 97).arg(i);
+    return {
+        {u"id"_s, 2000 + i},
+        {u"node_id"_s, u"MDEwOlJlcG9zaXRvcnk%1"_s.arg(i)},
+        {u"name"_s, u"repository-%1"_s.arg(i)},
+        {u"full_name"_s, full_name},
+        {u"private"_s, false},
+        {u"owner"_s, user(i % 97)},
+        {u"html_url"_s, u"https://github.com/%1"_s.arg(full_name)},
+        {u"description"_s, text(description_length, i)},
+        {u"fork"_s, i % 7 == 0},
+        {u"url"_s, u"%1/repos/%2"_s.arg(api, full_name)},
+        {u"created_at"_s, u"2015-03-01T12:00:00Z"_s},
+        {u"updated_at"_s, u"2025-06-%1T08:30:00Z"_s.arg(1 + i % 28, 2, 10, u'0')},
+        {u"pushed_at"_s, u"2025-06-%1T08:29:00Z"_s.arg(1 + i % 28, 2, 10, u'0')},
+        {u"homepage"_s, u"https://example.org"_s},
+        {u"size"_s, 4096 + i},
+        {u"stargazers_count"_s, i * 13},
+        {u"watchers_count"_s, i * 13},
+        {u"language"_s, i % 3 ? u"C++"_s : u"Python"_s},
+        {u"forks_count"_s, i * 3},
+        {u"open_issues_count"_s, i % 50},
+        {u"has_issues"_s, true},
+        {u"has_projects"_s, true},
+        {u"has_downloads"_s, true},
+        {u"has_wiki"_s, i % 2 == 0},
+        {u"has_pages"_s, false},
+        {u"has_discussions"_s, i % 4 == 0},
+        {u"archived"_s, i % 11 == 0},
+        {u"license"_s, QJsonObject{{u"key"_s, u"mit"_s},
+                                   {u"name"_s, u"MIT License"_s},
+                                   {u"spdx_id"_s, u"MIT"_s}}},
+        {u"topics"_s, QJsonArray{u"launcher"_s, u"productivity"_s, u"qt"_s}},
+        {u"visibility"_s, u"public"_s},
+        {u"default_branch"_s, u"main"_s},
+        {u"score"_s, 1.0}
+    };
+}
+
+QJsonObject issue(int i, bool reaction_heavy)
+{
+    static const QStringList label_names{u"bug"_s, u"enhancement"_s, u"help wanted"_s,
+                                         u"good first issue"_s, u"documentation"_s,
+                                         u"needs triage"_s};
+    const auto repository = u"user%1/repository-%2"_s.arg(i % 97).arg(i % 13);
+    const auto url = u"%1/repos/%2/issues/%3"_s.arg(api, repository).arg(i);
+
+    QJsonArray labels;
+    for (int l = 0; l < (reaction_heavy ? label_names.size() : i % 2); ++l)
+        labels.append(QJsonObject{{u"id"_s, 3000 + l},
+                                  {u"name"_s, label_names[l]},
+                                  {u"color"_s, u"d73a4a"_s},
+                                  {u"default"_s, true},
+                                  {u"description"_s, text(40, l)}});
+
+    QJsonObject reactions{{u"url"_s, url + u"/reactions"_s}};
+    int total = 0;
+    for (const auto key : {"+1", "-1", "laugh", "hooray", "confused", "heart", "rocket", "eyes"})
+    {
+        const auto count = reaction_heavy ? 1 + (i + total) % 40 : 0;
+        reactions.insert(QLatin1StringView(key), count);
+        total += count;
+    }
+    reactions.insert(u"total_count"_s, total);
+
+    QJsonObject o{
+        {u"url"_s, url},
+        {u"repository_url"_s, u"%1/repos/%2"_s.arg(api, repository)},
+        {u"comments_url"_s, url + u"/comments"_s},
+        {u"html_url"_s, u"https://github.com/%1/issues/%2"_s.arg(repository).arg(i)},
+        {u"id"_s, 4000 + i},
+        {u"node_id"_s, u"I_kwDOAbc%1"_s.arg(i)},
+        {u"number"_s, i},
+        {u"title"_s, text(60, i)},
+        {u"user"_s, user(i % 97)},
+        {u"labels"_s, labels},
+        {u"state"_s, i % 3 ? u"open"_s : u"closed"_s},
+        {u"locked"_s, false},
+        {u"assignee"_s, QJsonValue::Null},
+        {u"assignees"_s, QJsonArray{}},
+        {u"milestone"_s, QJsonValue::Null},
+        {u"comments"_s, i % 17},
+        {u"created_at"_s, u"2025-01-01T00:00:00Z"_s},
+        {u"updated_at"_s, u"2025-06-%1T08:30:00Z"_s.arg(1 + i % 28, 2, 10, u'0')},
+        {u"closed_at"_s, QJsonValue::Null},
+        {u"author_association"_s, u"CONTRIBUTOR"_s},
+        {u"body"_s, text(400, i)},
+        {u"reactions"_s, reactions},
+        {u"timeline_url"_s, url + u"/timeline"_s},
+        {u"score"_s, 1.0}
+    };
+    if (i % 4 == 0)
+        o.insert(u"pull_request"_s,
+                 QJsonObject{{u"url"_s, url}, {u"merged_at"_s, QJsonValue::Null}});
+    return o;
+}
+
+template<class F>
+QByteArray page(int count, F item)
+{
+    QJsonArray items;
+    for (int i = 0; i < count; ++i)
+        items.append(item(i));
+    return QJsonDocument(QJsonObject{{u"total_count"_s, count},
+                                     {u"incomplete_results"_s, false},
+                                     {u"items"_s, items}}).toJson(QJsonDocument::Compact);
+}
+
+}
+
+QByteArray fixtures::users(int count) { return page(count, user); }
+
+QByteArray fixtures::repositories(int count, int description_length)
+{ return page(count, [=](int i){ return repository(i, description_length); }); }
+
+QByteArray fixtures::issues(int count, bool reaction_heavy)
+{ return page(count, [=](int i){ return issue(i, reaction_heavy); }); }
@@ -0,0 +1,23 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#pragma once
+#include <QByteArray>
+
+///
+/// Search responses shaped like the ones of the GitHub REST API, including the fields the items
+/// do not use. Deterministic.
+///
+namespace fixtures
+{
+
+/// A search response of `count` users.
+QByteArray users(int count);
+
+/// A search response of `count` repositories with descriptions of `description_length`
+/// characters.
+QByteArray repositories(int count, int description_length = 80);
+
+/// A search response of `count` issues. Reaction heavy issues have all reactions and many labels.
+QByteArray issues(int count, bool reaction_heavy = false);
+
+}
@@ -0,0 +1,5 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+// The plugin gets its logging category from the plugin macros, the benchmarks define their own
+#include <QLoggingCategory>
+Q_LOGGING_CATEGORY(AlbertLoggingCategory, "albert.github", QtWarningMsg)
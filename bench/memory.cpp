@@ -0,0 +1,78 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "memory.h"
+#include <QFile>
+#include <QByteArray>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sys/resource.h>
+#include <unistd.h>
+using namespace std;
+
+static atomic<size_t> allocation_count = 0;
+
+#if defined(__GLIBC__)
+
+extern "C" {
+void *__libc_malloc(size_t);
+void *__libc_calloc(size_t, size_t);
+void *__libc_realloc(void *, size_t);
+
+void *malloc(size_t size)
+{
+    allocation_count.fetch_add(1, memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    allocation_count.fetch_add(1, memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *p, size_t size)
+{
+    allocation_count.fetch_add(1, memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+}
+
+#else
+
+void *operator new(size_t size)
+{
+    allocation_count.fetch_add(1, memory_order_relaxed);
+    if (auto *p = std::malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+#endif
+
+size_t memory::allocations() { return allocation_count.load(memory_order_relaxed); }
+
+size_t memory::currentRss()
+{
+#if defined(Q_OS_LINUX)
+    if (QFile file(QStringLiteral("/proc/self/statm")); file.open(QIODevice::ReadOnly))
+        if (const auto fields = file.readAll().split(' '); fields.size() > 1)
+            return fields[1].toULongLong() * static_cast<size_t>(sysconf(_SC_PAGESIZE)) / 1024;
+#endif
+    return 0;
+}
+
+size_t memory::peakRss()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(Q_OS_MACOS)
+    return static_cast<size_t>(usage.ru_maxrss) / 1024;  // bytes
+#else
+    return static_cast<size_t>(usage.ru_maxrss);  // KiB
+#endif
+}
@@ -0,0 +1,22 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#pragma once
+#include <cstddef>
+
+///
+/// Process memory statistics for the benchmarks.
+///
+namespace memory
+{
+
+/// Returns the number of heap allocations of the process so far. Counts malloc on glibc, which
+/// also serves operator new and the Qt containers, and operator new elsewhere. Thread-safe.
+size_t allocations();
+
+/// Returns the resident set size of the process in KiB or 0 if unknown.
+size_t currentRss();
+
+/// Returns the peak resident set size of the process in KiB.
+size_t peakRss();
+
+}
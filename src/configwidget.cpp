@@ -62,6 +62,13 @@ public:
                          QObject *parent = nullptr)
         : QAbstractItemModel(parent), handlers_(handlers)
     {
+        for (int row = 0; row < (int)handlers_.size(); ++row)
+            connect(handlers_[row].get(), &GithubSearchHandler::resultCountsChanged, this,
+                    [this, row] {
+                        const auto parent = index(row, 0);
+                        emit dataChanged(index(0, 2, parent),
+                                         index(rowCount(parent) - 1, 2, parent));
+                    });
     }
 
     QModelIndex index(int row, int column, const QModelIndex &parent = {}) const override
@@ -94,13 +101,16 @@ public:
         return 0;
     }
 
-    int columnCount(const QModelIndex &) const override { return 2; }
+    int columnCount(const QModelIndex &) const override { return 3; }
 
     QVariant headerData(int section, Qt::Orientation, int role) const override
     {
         if (role == Qt::DisplayRole)
-            return section == 0 ? ConfigWidget::tr("Title")
-                                : ConfigWidget::tr("Query");
+            switch (section) {
+            case 0: return ConfigWidget::tr("Title");
+            case 1: return ConfigWidget::tr("Query");
+            case 2: return ConfigWidget::tr("Results");
+            }
         return {};
     }
 
@@ -108,6 +118,8 @@ public:
     {
         if (!index.isValid())
             return Qt::NoItemFlags;
+        else if (index.parent().isValid() && index.column() == 2)
+            return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
         else if (index.parent().isValid())
             return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsEditable;
         else
@@ -138,14 +150,20 @@ public:
         {
             if (index.row() == (int)handlers_.at(parent.row())->savedSearches().size())  // vrow
             {
-                if (role == Qt::DisplayRole)
+                if (role == Qt::DisplayRole && index.column() < 2)
                     return index.column() == 0 ? ConfigWidget::tr("New search") : u"…"_s;
                 else if (role == Qt::ForegroundRole)
                     return qApp->palette().placeholderText();
             }
             else
             {
-                if (role == Qt::DisplayRole || role == Qt::EditRole)
+                if (role == Qt::DisplayRole && index.column() == 2)
+                {
+                    const auto &h = handlers_.at(parent.row());
+                    const auto count = h->resultCount(h->savedSearches().at(index.row()).second);
+                    return count ? QVariant(*count) : QVariant();
+                }
+                else if (role == Qt::DisplayRole || role == Qt::EditRole)
                 {
                     const auto ss = handlers_.at(parent.row())->savedSearches().at(index.row());
                     return index.column() == 0 ? ss.first : ss.second;
@@ -253,6 +271,18 @@ ConfigWidget::ConfigWidget(Plugin &p, OAuth2 &oauth) :
     ui.treeView->resizeColumnToContents(0);
     connect(ui.treeView->model(), &QAbstractItemModel::dataChanged,
             this, [tv=ui.treeView] { tv->resizeColumnToContents(0); });
+
+    ui.lineEdit_pinned_repositories->setText(plugin_.pinnedRepositories().join(QChar::Space));
+    connect(ui.lineEdit_pinned_repositories, &QLineEdit::editingFinished, this, [this] {
+        plugin_.setPinnedRepositories(
+            ui.lineEdit_pinned_repositories->text().split(QChar::Space, Qt::SkipEmptyParts));
+    });
+
+    ui.lineEdit_organizations->setText(plugin_.organizations().join(QChar::Space));
+    connect(ui.lineEdit_organizations, &QLineEdit::editingFinished, this, [this] {
+        plugin_.setOrganizations(
+            ui.lineEdit_organizations->text().split(QChar::Space, Qt::SkipEmptyParts));
+    });
 }
 
 #include "configwidget.moc"
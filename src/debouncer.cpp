@@ -0,0 +1,72 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "debouncer.h"
+#include <QCoroSignal>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+using namespace github;
+using namespace std::chrono;
+using namespace std;
+
+namespace
+{
+static const auto alpha = 0.25;           // EWMA smoothing factor
+static const auto burst_timeout = 1500ms; // Longer intervals start a new typing burst
+static const auto min_delay = 50ms;
+static const auto max_delay = 600ms;
+}
+
+bool TypingDebouncer::keystroke(const QString &query)
+{
+    lock_guard lock(mutex_);
+
+    // Typing changes a character at a time, activations replace the query
+    const auto typed = query.size() <= 1 || abs(query.size() - last_query_.size()) <= 1;
+    last_query_ = query;
+    if (!typed)
+        return false;
+
+    const auto now = clock::now();
+    if (const auto interval = duration_cast<milliseconds>(now - last_keystroke_);
+        interval < burst_timeout)
+        keystroke_interval_ += alpha * (interval.count() - keystroke_interval_);
+    last_keystroke_ = now;
+    return true;
+}
+
+milliseconds TypingDebouncer::remaining()
+{
+    lock_guard lock(mutex_);
+
+    // Wait a bit longer than the usual gap between keystrokes. Slow responses make wasted
+    // requests more expensive since they occupy a request slot longer, so wait longer then.
+    const auto gap = clamp(milliseconds(lround(1.5 * keystroke_interval_
+                                               + 0.1 * round_trip_time_)),
+                           milliseconds(min_delay), milliseconds(max_delay));
+
+    const auto elapsed = duration_cast<milliseconds>(clock::now() - last_keystroke_);
+    return max(gap - elapsed, 0ms);
+}
+
+QCoro::Task<bool> TypingDebouncer::paused(function<bool()> alive)
+{
+    // A later keystroke moves the deadline, wait again
+    for (auto delay = remaining(); delay > 0ms; delay = remaining())
+    {
+        QTimer timer;
+        timer.setSingleShot(true);
+        timer.start(delay);
+        co_await qCoro(&timer, &QTimer::timeout);
+
+        if (!alive())
+            co_return false;
+    }
+    co_return alive();
+}
+
+void TypingDebouncer::roundTrip(milliseconds rtt)
+{
+    lock_guard lock(mutex_);
+    round_trip_time_ += alpha * (rtt.count() - round_trip_time_);
+}
@@ -0,0 +1,50 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#pragma once
+#include <QCoroTask>
+#include <QString>
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+namespace github
+{
+
+///
+/// Learns the typing rhythm and the request round trip time to tell when typing paused.
+///
+/// A query fires as soon as the user paused typing longer than usual. Every keystroke rearms the
+/// wait. Queries superseded while waiting are never sent. Thread-safe.
+///
+class TypingDebouncer
+{
+public:
+
+    using clock = std::chrono::steady_clock;
+    using milliseconds = std::chrono::milliseconds;
+
+    /// Records a keystroke, i.e. a new `query`. Returns false if the query was not typed but
+    /// entered at once, e.g. by activating a saved search, and should be dispatched immediately.
+    bool keystroke(const QString &query);
+
+    /// Returns the time left until typing paused, i.e. until the adaptive gap elapsed since the
+    /// last keystroke. Zero once typing paused.
+    milliseconds remaining();
+
+    /// Waits until typing paused. Returns false as soon as `alive` returned false.
+    QCoro::Task<bool> paused(std::function<bool()> alive);
+
+    /// Records the round trip time of a request.
+    void roundTrip(milliseconds);
+
+private:
+
+    std::mutex mutex_;
+    QString last_query_;
+    clock::time_point last_keystroke_;
+    double keystroke_interval_ = 150;  // ms, exponentially weighted moving average
+    double round_trip_time_ = 500;     // ms, exponentially weighted moving average
+
+};
+
+}
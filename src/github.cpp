@@ -1,20 +1,35 @@
 // Copyright (c) 2025-2025 Manuel Schneider
 
 #include "github.h"
+#include "items.h"
+#include "scheduler.h"
+#include "tracing.h"
 #include <QCoreApplication>
+#include <QCoroFuture>
+#include <QCoroSignal>
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
+#include <QPromise>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
 #include <QUrlQuery>
+#include <QtConcurrentRun>
 #include <albert/logging.h>
 #include <albert/networkutil.h>
 using namespace Qt::StringLiterals;
 using namespace albert;
 using namespace github;
 using namespace std;
+using namespace std::chrono_literals;
 
 namespace
 {
@@ -25,18 +40,78 @@ static const auto kcode           = "code"_L1;
 static const auto oauth_auth_url  = u"https://github.com/login/oauth/authorize"_s;
 static const auto oauth_scope     = u"notifications,read:org,read:user"_s;
 static const auto oauth_token_url = u"https://github.com/login/oauth/access_token"_s;
+static const uint max_retries = 5;
+static const auto max_retry_delay = 60s;
+static const auto backoff_base = 1s;
+static const uint max_concurrent_requests = 4;
+static const uint offline_threshold = 3;  // consecutive connection failures
+static const auto min_probe_delay = 5s;
+static const auto max_probe_delay = 5min;
+static const auto transfer_timeout = 15s;
+static const int min_hedge_headroom = 5;  // remaining search requests
+
+// Parsing is CPU bound, keep it off the network thread and the query threads
+struct ParserThreadPool : QThreadPool { ParserThreadPool() { setMaxThreadCount(2); } };
+static ParserThreadPool parser_thread_pool;
 }
 // -------------------------------------------------------------------------------------------------
 
 
-variant<QJsonDocument, QString> RestApi::parseJson(QNetworkReply &reply)
+Response Response::take(QNetworkReply &reply)
+{
+    bool transient = false;
+    bool unreachable = false;
+    switch (reply.error())
+    {
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+        transient = true;
+        unreachable = true;
+        break;
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::OperationCanceledError:  // transfer timeout
+    case QNetworkReply::SslHandshakeFailedError:  // e.g. captive portals
+    case QNetworkReply::ProxyConnectionRefusedError:
+    case QNetworkReply::ProxyNotFoundError:
+    case QNetworkReply::ProxyTimeoutError:
+    case QNetworkReply::UnknownNetworkError:
+        unreachable = true;
+        break;
+    default:
+        break;
+    }
+
+    const auto status = reply.attribute(QNetworkRequest::HttpStatusCodeAttribute);
+    return {.status = status.isValid() ? status.toInt() : 0,
+            .error = reply.error() != QNetworkReply::NoError,
+            .transient = transient,
+            .unreachable = unreachable,
+            .error_string = reply.errorString(),
+            .body = reply.readAll(),
+            .headers = reply.rawHeaderPairs()};
+}
+
+QByteArray Response::header(const QByteArray &name) const
+{
+    for (const auto &[key, value] : headers)
+        if (key.compare(name, Qt::CaseInsensitive) == 0)
+            return value;
+    return {};
+}
+
+// -------------------------------------------------------------------------------------------------
+
+Expected<QJsonDocument> RestApi::parseJson(const Response &response)
 {
-    const QByteArray data = reply.readAll();
+    const QByteArray &data = response.body;
 
     QJsonParseError parseError;
     const auto doc = QJsonDocument::fromJson(data, &parseError);
 
-    if (reply.error() == QNetworkReply::NoError)
+    if (!response.error)
     {
         if (parseError.error == QJsonParseError::NoError)
             return doc;
@@ -61,7 +136,76 @@ variant<QJsonDocument, QString> RestApi::parseJson(QNetworkReply &reply)
         return message.isEmpty() ? QString::fromUtf8(data) : message;
     }
 
-    return u"%1: %2"_s.arg(reply.errorString(), QString::fromUtf8(data));
+    if (data.isEmpty())
+        return response.error_string;
+    return u"%1: %2"_s.arg(response.error_string, QString::fromUtf8(data));
+}
+
+optional<chrono::milliseconds> RestApi::retryDelay(const Response &response, uint attempt)
+{
+    if (attempt >= max_retries)
+        return {};
+
+    const auto backoff = [attempt]{
+        // Exponential backoff with "equal jitter"
+        const chrono::milliseconds cap = backoff_base * (1 << attempt);
+        const auto jitter = QRandomGenerator::global()->bounded(cap.count() / 2 + 1);
+        return cap / 2 + chrono::milliseconds(jitter);
+    };
+
+    optional<chrono::milliseconds> delay;
+
+    switch (response.status)
+    {
+    case 403:
+    case 429:
+        // https://docs.github.com/en/rest/using-the-rest-api/best-practices-for-using-the-rest-api#handle-rate-limit-errors-appropriately
+        if (const auto retry_after = response.header("Retry-After"); !retry_after.isEmpty())
+            delay = chrono::seconds(retry_after.toLongLong());
+
+        else if (const auto reset = response.header("X-RateLimit-Reset");
+                 response.header("X-RateLimit-Remaining") == "0" && !reset.isEmpty())
+            delay = chrono::seconds(reset.toLongLong() - QDateTime::currentSecsSinceEpoch() + 1);
+
+        else if (response.status == 429 || response.body.contains("secondary rate limit"))
+            delay = max(chrono::milliseconds(chrono::seconds(10)), backoff());
+        break;
+
+    case 500:
+    case 502:
+    case 503:
+    case 504:
+        delay = backoff();
+        break;
+
+    case 0:  // No HTTP response
+        if (response.transient)
+            delay = backoff();
+        break;
+
+    default:
+        break;
+    }
+
+    if (delay && *delay > max_retry_delay)
+        return {};  // Do not keep the user waiting for minutes, e.g. for the primary rate limit
+
+    return delay ? max(*delay, chrono::milliseconds(0)) : delay;
+}
+
+map<QString, QUrl> RestApi::links(const Response &response)
+{
+    // https://docs.github.com/en/rest/using-the-rest-api/using-pagination-in-the-rest-api
+    // Format: <https://api.github.com/...&page=2>; rel="next", <...&page=34>; rel="last"
+    static const QRegularExpression re(uR"re(<([^>]*)>\s*;\s*rel="([^"]*)")re"_s);
+
+    map<QString, QUrl> links;
+    for (auto it = re.globalMatch(QString::fromUtf8(response.header("Link"))); it.hasNext();)
+    {
+        const auto m = it.next();
+        links.emplace(m.captured(2), QUrl(m.captured(1)));
+    }
+    return links;
 }
 
 QNetworkRequest RestApi::request(const QString &path, const QUrlQuery &query) const
@@ -69,28 +213,48 @@ QNetworkRequest RestApi::request(const QString &path, const QUrlQuery &query) co
     QUrl url(u"https://api.github.com"_s);
     url.setPath(path);
     url.setQuery(query);
+    return request(url);
+}
 
+QNetworkRequest RestApi::request(const QUrl &url) const
+{
     QNetworkRequest request(url);
     request.setRawHeader("Accept", "application/vnd.github+json");
     request.setRawHeader("X-GitHub-Api-Version", "2022-11-28");
 
-    if (oauth.state() == OAuth2::State::Granted)
+    if (isAuthorized())
         request.setRawHeader("Authorization", "Bearer " + oauth.accessToken().toUtf8());
 
+    request.setTransferTimeout(transfer_timeout);
+
     return request;
 }
 
 // -------------------------------------------------------------------------------------------------
 
-RestApi::RestApi()
+RestApi::RestApi():
+    scheduler_(make_unique<RequestScheduler>(chrono::milliseconds(rateLimit()),
+                                             max_concurrent_requests)),
+    network_thread_(make_unique<QThread>()),
+    network_context_(make_unique<QObject>())
 {
+    network_thread_->setObjectName(u"GitHub network"_s);
+    network_context_->moveToThread(network_thread_.get());
+    network_thread_->start();
+
     oauth.setAuthUrl(oauth_auth_url);
     oauth.setScope(oauth_scope);
     oauth.setTokenUrl(oauth_token_url);
     oauth.setRedirectUri("%1://github/"_L1.arg(qApp->applicationName()));
     oauth.setPkceEnabled(false);
 
+    QObject::connect(&oauth, &OAuth2::stateChanged, scheduler_.get(), [this] {
+        scheduler_->setDelay(chrono::milliseconds(rateLimit()));
+    });
+
     QObject::connect(&oauth, &OAuth2::tokensChanged, &oauth, [this] {
+        token_rejected_ = false;
+        scheduler_->setDelay(chrono::milliseconds(rateLimit()));
         if (oauth.error().isEmpty())
             DEBG << "Tokens updated.";
         else
@@ -98,6 +262,221 @@ RestApi::RestApi()
     });
 }
 
+RestApi::~RestApi()
+{
+    network_thread_->quit();
+    network_thread_->wait();
+}
+
+RequestScheduler &RestApi::scheduler() const { return *scheduler_; }
+
+QCoro::Task<optional<Response>> RestApi::send(function<QNetworkReply*()> send,
+                                              RequestScheduler::Priority priority,
+                                              function<bool()> alive,
+                                              quint64 trace_id,
+                                              optional<chrono::milliseconds> hedge_after) const
+{
+    if (offline_)
+        co_return Response{.error = true,
+                           .unreachable = true,
+                           .error_string = u"GitHub is unreachable"_s};
+
+    trace::Span wait_span("wait", trace_id);
+    const auto ticket = scheduler_->acquire(priority, alive);
+    co_await qCoro(ticket.get(), &RequestTicket::granted);
+    wait_span.end();
+
+    if (alive && !alive())
+        co_return nullopt;
+
+    // Replies live on the network thread, responses are moved to the awaiting thread
+    auto promise = make_shared<QPromise<Response>>();
+    auto future = promise->future();
+    promise->start();
+
+    QMetaObject::invokeMethod(network_context_.get(),
+                              [this, send = ::move(send), promise, trace_id, hedge_after] {
+        QElapsedTimer timer;
+        timer.start();
+        const auto begin = trace::now();
+        auto replies = make_shared<vector<QNetworkReply*>>();
+
+        const auto dispatch = [=, this](bool hedge) {
+            auto *reply = send();
+            const auto url = reply->request().url();
+            DEBG << (hedge ? "Hedge" : "Fetch") << url;
+            replies->push_back(reply);
+
+            if (trace::enabled())
+                QObject::connect(reply, &QNetworkReply::metaDataChanged, reply, [=] {
+                    trace::complete("first byte", trace_id, begin, trace::now());
+                }, Qt::SingleShotConnection);
+
+            QObject::connect(reply, &QNetworkReply::finished, reply, [=, this] {
+                reply->deleteLater();
+                if (promise->future().isFinished())
+                    return;  // aborted loser
+
+                trace::complete(hedge ? "hedge request" : "request", trace_id,
+                                begin, trace::now(), url.toString());
+                auto response = Response::take(*reply);
+                response.elapsed = chrono::milliseconds(timer.elapsed());
+                response.hedged = replies->size() > 1;
+                recordReachability(response);
+                if (response.header("X-RateLimit-Resource") == "search")
+                    search_remaining_ = response.header("X-RateLimit-Remaining").toInt();
+                promise->addResult(::move(response));
+                promise->finish();
+
+                for (auto *other : *replies)
+                    if (other != reply)
+                        other->abort();
+            });
+        };
+
+        dispatch(false);
+
+        if (hedge_after)
+            QTimer::singleShot(*hedge_after, replies->front(), [=, this] {
+                if (!promise->future().isFinished() && !offline_
+                    && search_remaining_ > min_hedge_headroom)
+                {
+                    --search_remaining_;
+                    dispatch(true);
+                }
+            });
+    }, Qt::QueuedConnection);
+
+    auto response = co_await qCoro(future).takeResult();
+    ticket->release();
+    co_return response;
+}
+
+bool RestApi::isOffline() const { return offline_; }
+
+bool RestApi::isAuthorized() const
+{ return oauth.state() == OAuth2::State::Granted && !token_rejected_; }
+
+void RestApi::recordReachability(const Response &response) const
+{
+    if (!response.unreachable)
+        connection_failures_ = 0;
+    else if (++connection_failures_ >= offline_threshold && !offline_.exchange(true))
+    {
+        WARN << "GitHub is unreachable, answering requests from the cache until it is back.";
+        probe();
+    }
+}
+
+QCoro::Task<> RestApi::probe() const
+{
+    for (chrono::milliseconds delay = min_probe_delay;;
+         delay = min<chrono::milliseconds>(delay * 2, max_probe_delay))
+    {
+        QTimer timer;
+        timer.setSingleShot(true);
+        timer.start(delay);
+        co_await qCoro(&timer, &QTimer::timeout);
+
+        auto *reply = rateLimits();
+        co_await qCoro(reply, &QNetworkReply::finished);
+        const auto response = Response::take(*reply);
+        reply->deleteLater();
+
+        if (!response.unreachable)
+        {
+            INFO << "GitHub is reachable again.";
+            connection_failures_ = 0;
+            offline_ = false;
+            co_return;
+        }
+        DEBG << "GitHub still unreachable:" << response.error_string;
+    }
+}
+
+QCoro::Task<bool> RestApi::warmUp()
+{
+    const auto authorized = isAuthorized();
+    const auto response = co_await send([this]{ return rateLimits(); },
+                                        RequestScheduler::Priority::Background);
+
+    if (response->status == 401 && authorized)
+    {
+        // Keep the stored token, a single probe is no reason to destroy credentials
+        WARN << "The access token has been rejected. Please authorize again.";
+        token_rejected_ = true;
+        scheduler_->setDelay(chrono::milliseconds(rateLimit()));
+        co_return false;
+    }
+    else if (response->error)
+        WARN << "Failed to connect:" << response->error_string;
+    else
+        DEBG << u"Connected in %1 ms, %2 requests remaining"_s
+                    .arg(response->elapsed.count())
+                    .arg(QString::fromUtf8(response->header("X-RateLimit-Remaining")));
+    co_return true;
+}
+
+template<class T>
+QCoro::Task<Expected<T>> RestApi::parse(Response response,
+                                        function<Expected<T>(const Response &)> parse)
+{
+    auto future = QtConcurrent::run(&parser_thread_pool,
+                                    [response = ::move(response), parse = ::move(parse)]
+                                    { return parse(response); });
+    co_return co_await qCoro(future).takeResult();
+}
+
+template<class T>
+QCoro::Task<Expected<T>> RestApi::fetch(function<QNetworkReply*()> send,
+                                        RequestScheduler::Priority priority,
+                                        function<Expected<T>(const Response &)> parse,
+                                        function<bool()> alive,
+                                        quint64 trace_id) const
+{
+    for (uint attempt = 0;; ++attempt)
+    {
+        auto response = co_await this->send(send, priority, alive, trace_id);
+        if (!response)
+            co_return u"Cancelled"_s;
+
+        if (response->error)
+            if (const auto delay = retryDelay(*response, attempt); delay)
+            {
+                DEBG << u"Request failed (%1). Retry %2 in %3 ms."_s
+                            .arg(response->status ? QString::number(response->status)
+                                                  : response->error_string)
+                            .arg(attempt + 1).arg(delay->count());
+                QTimer timer;
+                timer.setSingleShot(true);
+                timer.start(*delay);
+                co_await qCoro(&timer, &QTimer::timeout);
+                continue;
+            }
+
+        trace::Span parse_span("parse", trace_id);
+        co_return co_await RestApi::parse<T>(::move(*response), parse);
+    }
+}
+
+// Explicit instantiations of the result types in use
+template QCoro::Task<Expected<QJsonDocument>>
+RestApi::parse<QJsonDocument>(Response, function<Expected<QJsonDocument>(const Response &)>);
+template QCoro::Task<Expected<SearchPage>>
+RestApi::parse<SearchPage>(Response, function<Expected<SearchPage>(const Response &)>);
+template QCoro::Task<Expected<QJsonDocument>>
+RestApi::fetch<QJsonDocument>(function<QNetworkReply*()>, RequestScheduler::Priority,
+               function<Expected<QJsonDocument>(const Response &)>, function<bool()>,
+               quint64) const;
+template QCoro::Task<Expected<SearchPage>>
+RestApi::fetch<SearchPage>(function<QNetworkReply*()>, RequestScheduler::Priority,
+               function<Expected<SearchPage>(const Response &)>, function<bool()>,
+               quint64) const;
+template QCoro::Task<Expected<QStringList>>
+RestApi::fetch<QStringList>(function<QNetworkReply*()>, RequestScheduler::Priority,
+               function<Expected<QStringList>(const Response &)>, function<bool()>,
+               quint64) const;
+
 QNetworkReply *RestApi::user() const
 {
     // https://docs.github.com/en/rest/users/users#get-the-authenticated-user
@@ -111,35 +490,106 @@ QNetworkReply *RestApi::notifications() const
                                  {{u"all"_s, u"true"_s}}));
 }
 
-QNetworkReply *RestApi::searchUsers(const QString &query, int per_page, int page) const
+QNetworkReply *RestApi::rateLimits() const
+{
+    // https://docs.github.com/en/rest/rate-limit/rate-limit#get-rate-limit-status-for-the-authenticated-user
+    return network().get(request(u"/rate_limit"_s, {}));
+}
+
+QNetworkReply *RestApi::searchUsers(const QString &query,
+                                    int per_page,
+                                    int page,
+                                    const QByteArray &etag) const
 {
     // https://docs.github.com/en/rest/search/search#search-users
-    return network().get(request(u"/search/users"_s,
-                                 {{u"q"_s, percentEncoded(query)},
-                                  {u"per_page"_s, QString::number(per_page)},
-                                  {u"page"_s, QString::number(page)}}));
+    auto r = request(u"/search/users"_s,
+                     {{u"q"_s, percentEncoded(query)},
+                      {u"per_page"_s, QString::number(per_page)},
+                      {u"page"_s, QString::number(page)}});
+    if (!etag.isEmpty())
+        r.setRawHeader("If-None-Match", etag);
+    return network().get(r);
 }
 
-QNetworkReply *RestApi::searchIssues(const QString &query, int per_page, int page) const
+QNetworkReply *RestApi::searchIssues(const QString &query,
+                                     int per_page,
+                                     int page,
+                                     const QByteArray &etag) const
 {
     // https://docs.github.com/en/rest/search/search#search-repositories
-    return network().get(request(u"/search/issues"_s,
-                                 {{u"q"_s, percentEncoded(query)},
-                                  {u"per_page"_s, QString::number(per_page)},
-                                  {u"page"_s, QString::number(page)},
-                                  {u"advanced_search"_s, u"true"_s}}));
+    auto r = request(u"/search/issues"_s,
+                     {{u"q"_s, percentEncoded(query)},
+                      {u"per_page"_s, QString::number(per_page)},
+                      {u"page"_s, QString::number(page)},
+                      {u"advanced_search"_s, u"true"_s}});
+    if (!etag.isEmpty())
+        r.setRawHeader("If-None-Match", etag);
+    return network().get(r);
 }
 
-QNetworkReply *RestApi::searchRepositories(const QString &query, int per_page, int page) const
+QNetworkReply *RestApi::searchRepositories(const QString &query,
+                                           int per_page,
+                                           int page,
+                                           const QByteArray &etag) const
 {
     // https://docs.github.com/en/rest/search/search#search-issues-and-pull-requests
-    return network().get(request(u"/search/repositories"_s,
-                                 {{u"q"_s, percentEncoded(query)},
-                                  {u"per_page"_s, QString::number(per_page)},
-                                  {u"page"_s, QString::number(page)}}));
+    auto r = request(u"/search/repositories"_s,
+                     {{u"q"_s, percentEncoded(query)},
+                      {u"per_page"_s, QString::number(per_page)},
+                      {u"page"_s, QString::number(page)}});
+    if (!etag.isEmpty())
+        r.setRawHeader("If-None-Match", etag);
+    return network().get(r);
+}
+
+QNetworkReply *RestApi::repositoryIssues(const QString &repository,
+                                         const QString &since,
+                                         const QByteArray &etag) const
+{
+    // https://docs.github.com/en/rest/issues/issues#list-repository-issues
+    QUrlQuery query{{u"state"_s, u"all"_s},
+                    {u"sort"_s, u"updated"_s},
+                    {u"direction"_s, u"asc"_s},
+                    {u"per_page"_s, u"100"_s}};
+    if (!since.isEmpty())
+        query.addQueryItem(u"since"_s, since);
+
+    auto r = request(u"/repos/%1/issues"_s.arg(repository), query);
+    if (!etag.isEmpty())
+        r.setRawHeader("If-None-Match", etag);
+
+    return network().get(r);
+}
+
+QNetworkReply *RestApi::commitSha(const QString &repository,
+                                  const QString &ref,
+                                  const QByteArray &etag) const
+{
+    // https://docs.github.com/en/rest/commits/commits#get-a-commit
+    auto r = request(u"/repos/%1/commits/%2"_s.arg(repository, ref), {});
+    r.setRawHeader("Accept", "application/vnd.github.sha");
+    if (!etag.isEmpty())
+        r.setRawHeader("If-None-Match", etag);
+    return network().get(r);
+}
+
+QNetworkReply *RestApi::gitTree(const QString &repository, const QString &sha) const
+{
+    // https://docs.github.com/en/rest/git/trees#get-a-tree
+    return network().get(request(u"/repos/%1/git/trees/%2"_s.arg(repository, sha),
+                                 {{u"recursive"_s, u"1"_s}}));
+}
+
+QNetworkReply *RestApi::graphql(const QString &query, const QJsonObject &variables) const
+{
+    // https://docs.github.com/en/graphql/guides/forming-calls-with-graphql
+    auto r = request(QUrl(u"https://api.github.com/graphql"_s));
+    r.setHeader(QNetworkRequest::ContentTypeHeader, u"application/json"_s);
+    const QJsonObject body{{u"query"_s, query}, {u"variables"_s, variables}};
+    return network().post(r, QJsonDocument(body).toJson(QJsonDocument::Compact));
 }
 
-QNetworkReply * RestApi::getLinkData(const QString &url) const
-{ return network().get(request(url, {})); }
+QNetworkReply *RestApi::getLinkData(const QUrl &url) const
+{ return network().get(request(url)); }
 
-uint RestApi::rateLimit() const { return oauth.state() == OAuth2::State::Granted ? 2000 : 6000; }
+uint RestApi::rateLimit() const { return isAuthorized() ? 2000 : 6000; }
@@ -1,62 +1,191 @@
 // Copyright (c) 2025-2025 Manuel Schneider
 
 #pragma once
+#include "scheduler.h"
+#include <QByteArray>
+#include <QCoroTask>
+#include <QList>
+#include <QString>
+#include <QUrl>
 #include <albert/oauth.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <variant>
 class QJsonDocument;
+class QJsonObject;
 class QNetworkReply;
 class QNetworkRequest;
-class QString;
+class QThread;
 class QUrlQuery;
 
 namespace github
 {
 
+/// A result or an error message.
+template<class T>
+using Expected = std::variant<T, QString>;
+
+/// A finished reply, detached from its QNetworkReply. Can be passed across threads.
+struct Response
+{
+    int status = 0;        // HTTP status, 0 if there was no HTTP response
+    bool error = false;
+    bool transient = false;  // network error worth retrying
+    bool unreachable = false;  // no connection to the host, see RestApi::isOffline
+    bool hedged = false;  // a duplicate request was sent, see RestApi::send
+    QString error_string;    // of the network error
+    QByteArray body;
+    QList<std::pair<QByteArray, QByteArray>> headers;
+    std::chrono::milliseconds elapsed{0};  // since sent
+
+    /// Reads the body and the metadata of the finished `reply`.
+    static Response take(QNetworkReply &reply);
+
+    /// Returns the value of the header `name` (case-insensitive).
+    QByteArray header(const QByteArray &name) const;
+};
+
 class RestApi
 {
 public:
 
     RestApi();
+    ~RestApi();
 
     uint rateLimit() const;
 
+    /// Returns true if the API has been unreachable for several requests in a row.
+    ///
+    /// While offline, requests are not sent but answered immediately with an unreachable
+    /// response. A background probe with exponential backoff detects the reconnection.
+    /// Thread-safe.
+    bool isOffline() const;
+
+    /// Returns true if the OAuth state is granted and the access token has not been rejected in
+    /// this session. Requests are sent unauthenticated otherwise. Thread-safe.
+    bool isAuthorized() const;
+
+    /// The scheduler all requests have to acquire a ticket from before they are sent.
+    RequestScheduler &scheduler() const;
+
     /// Requiress ``user`` scope
     [[nodiscard]] QNetworkReply *user() const;
 
     /// Requires the ``notifications`` or ``repo`` scopes.
     [[nodiscard]] QNetworkReply *notifications() const;
 
+    /// Does not count against the rate limit. Requires no scopes.
+    [[nodiscard]] QNetworkReply *rateLimits() const;
+
+    /// The search requests are conditional if `etag` is not empty.
     /// Requires no scopes (if public data is sufficient)
     [[nodiscard]] QNetworkReply* searchUsers(const QString &query,
                                              int per_page,
-                                             int page) const;
+                                             int page,
+                                             const QByteArray &etag = {}) const;
 
     /// Requires no scopes (if public data is sufficient)
     [[nodiscard]] QNetworkReply* searchRepositories(const QString &query,
                                                     int per_page,
-                                                    int page) const;
+                                                    int page,
+                                                    const QByteArray &etag = {}) const;
 
     /// Requires no scopes (if public data is sufficient)
     [[nodiscard]] QNetworkReply* searchIssues(const QString &query,
                                               int per_page,
-                                              int page) const;
-
-    [[nodiscard]] QNetworkReply *getLinkData(const QString & url) const;
-
-    static std::variant<QJsonDocument, QString> parseJson(QNetworkReply &reply);
+                                              int page,
+                                              const QByteArray &etag = {}) const;
+
+    /// Lists issues and pull requests of `repository` updated at or after `since` (ISO 8601),
+    /// oldest first. Conditional if `etag` is not empty. Requires no scopes (if public data is
+    /// sufficient).
+    [[nodiscard]] QNetworkReply *repositoryIssues(const QString &repository,
+                                                  const QString &since,
+                                                  const QByteArray &etag) const;
+
+    /// Returns the SHA of the commit `ref` of `repository` as plain text. Conditional if `etag` is
+    /// not empty. Requires no scopes (if public data is sufficient).
+    [[nodiscard]] QNetworkReply *commitSha(const QString &repository,
+                                           const QString &ref,
+                                           const QByteArray &etag) const;
+
+    /// Lists the entries of the git tree `sha` of `repository` recursively.
+    /// Requires no scopes (if public data is sufficient).
+    [[nodiscard]] QNetworkReply *gitTree(const QString &repository, const QString &sha) const;
+
+    /// Posts a GraphQL `query` with `variables`. Requires authorization.
+    [[nodiscard]] QNetworkReply *graphql(const QString &query,
+                                         const QJsonObject &variables) const;
+
+    /// Fetches a URL of a ``Link`` header, e.g. the next page of a paginated resource.
+    [[nodiscard]] QNetworkReply *getLinkData(const QUrl &url) const;
+
+    /// Opens the connection to the API ahead of the first query and checks the access token.
+    /// Returns false if the token has been rejected. The stored token is kept, but queries fall
+    /// back to unauthenticated access for the session or until the tokens change.
+    QCoro::Task<bool> warmUp();
+
+    /// Acquires a ticket, sends the request created by `send` on the network thread and returns
+    /// the response. Returns `std::nullopt` if `alive` returned false meanwhile. Traces the wait
+    /// and the request as spans of `trace_id`.
+    ///
+    /// If `hedge_after` is set and the request did not finish by then, a duplicate is sent if the
+    /// search rate limit has headroom. The first response wins, the other request is aborted.
+    QCoro::Task<std::optional<Response>> send(
+        std::function<QNetworkReply*()> send,
+        RequestScheduler::Priority priority,
+        std::function<bool()> alive = {},
+        quint64 trace_id = 0,
+        std::optional<std::chrono::milliseconds> hedge_after = {}) const;
+
+    /// Parses `response` using `parse` on the parser thread pool.
+    template<class T>
+    static QCoro::Task<Expected<T>> parse(Response response,
+                                          std::function<Expected<T>(const Response &)> parse);
+
+    /// Sends, retries transient failures and parses. See send and parse.
+    template<class T>
+    QCoro::Task<Expected<T>> fetch(std::function<QNetworkReply*()> send,
+                                   RequestScheduler::Priority priority,
+                                   std::function<Expected<T>(const Response &)> parse,
+                                   std::function<bool()> alive = {},
+                                   quint64 trace_id = 0) const;
+
+    /// Returns the URLs of the ``Link`` header of `response` by relation (next, prev, first, last).
+    static std::map<QString, QUrl> links(const Response &response);
+
+    static Expected<QJsonDocument> parseJson(const Response &response);
+
+    /// Returns the time to wait before retrying the failed `response` or `std::nullopt` if the
+    /// error is not transient or `attempt` exceeded the retry limit.
+    ///
+    /// Honours ``Retry-After`` and ``X-RateLimit-Reset`` of (secondary) rate limit responses and
+    /// uses exponential backoff with jitter for server and transient network errors.
+    static std::optional<std::chrono::milliseconds> retryDelay(const Response &response,
+                                                               uint attempt);
 
     albert::OAuth2 oauth;
 
 private:
 
     QNetworkRequest request(const QString &, const QUrlQuery &) const;
+    QNetworkRequest request(const QUrl &) const;
 
-};
-
-
-
-
-
+    void recordReachability(const Response &) const;  // network thread
+    QCoro::Task<> probe() const;  // network thread
 
+    std::atomic<bool> token_rejected_ = false;  // for the session, see warmUp, before scheduler_
+    std::unique_ptr<RequestScheduler> scheduler_;
+    std::unique_ptr<QThread> network_thread_;
+    std::unique_ptr<QObject> network_context_;  // lives in network_thread_
+    mutable std::atomic<uint> connection_failures_ = 0;  // consecutive
+    mutable std::atomic<bool> offline_ = false;
+    mutable std::atomic<int> search_remaining_ = -1;  // of the search rate limit, -1 if unknown
 
+};
 
 }
@@ -2,15 +2,29 @@
 
 #include "github.h"
 #include "handlers.h"
+#include "issueindex.h"
 #include "items.h"
+#include "memberdirectory.h"
 #include "plugin.h"
+#include "refresher.h"
+#include "scheduler.h"
+#include "tracing.h"
+#include "treeindex.h"
+#if defined(GITHUB_USE_SIMDJSON)
+#include "simdjsonparser.h"
+#endif
 #include <QCoroAsyncGenerator>
-#include <QCoroNetworkReply>
 #include <QCoroSignal>
+#include <QCoroTask>
+#include <QDate>
+#include <QElapsedTimer>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QRegularExpression>
+#include <QSet>
 #include <QThread>
+#include <QTimer>
 #include <albert/icon.h>
 #include <albert/logging.h>
 #include <albert/matcher.h>
@@ -19,6 +33,7 @@
 #include <albert/queryresults.h>
 #include <albert/standarditem.h>
 #include <albert/systemutil.h>
+#include <deque>
 #include <memory>
 #include <ranges>
 using namespace Qt::StringLiterals;
@@ -26,6 +41,55 @@ using namespace albert::detail;
 using namespace albert;
 using namespace github;
 using namespace std;
+using Priority = RequestScheduler::Priority;
+
+static const size_t max_result_sets = 8;
+static const size_t max_query_items = 500;    // kept formatted per query, older are compacted
+static const size_t max_cached_items = 2000;  // remembered by all result sets for refinements
+static const auto poll_tick = 1min;
+static const uint max_polls_per_tick = 2;  // search rate limit is 10 (30 authenticated) per minute
+static const auto min_poll_interval = 2min;
+static const auto max_poll_interval = 30min;
+static const qint64 max_search_results = 1000;  // GitHub search cap
+static const QDate github_epoch(2007, 10, 1);
+static const size_t latency_samples = 50;
+static const size_t min_latency_samples = 20;
+static const auto min_hedge_delay = 300ms;
+
+namespace
+{
+
+// A creation date range of a query
+struct Partition
+{
+    QDate from;
+    QDate to;
+    optional<SearchPage> first_page;  // empty if not probed yet
+};
+
+// Splits a partition into equal-width ranges expected to hold ~80 % of the result cap each
+vector<Partition> splitPartition(const Partition &p, qint64 count)
+{
+    const auto days = p.from.daysTo(p.to) + 1;
+    const auto n = clamp<qint64>(count * 5 / 4 / max_search_results + 1, 2, min<qint64>(days, 8));
+
+    vector<Partition> partitions;
+    for (qint64 i = 0; i < n; ++i)  // newest first
+        partitions.push_back({.from = p.to.addDays(1 - days * (i + 1) / n),
+                              .to = p.to.addDays(-(days * i / n))});
+    return partitions;
+}
+
+QString partitionQuery(const QString &query, const Partition &p, const QString &sort_qualifier)
+{
+    static const QRegularExpression re_sort(uR"((^|\s)sort:\S+)"_s);
+    return u"%1 created:%2..%3 %4"_s.arg(QString(query).remove(re_sort).trimmed(),
+                                          p.from.toString(Qt::ISODate),
+                                          p.to.toString(Qt::ISODate),
+                                          sort_qualifier);
+}
+
+}
 
 static unique_ptr<Icon> makeGithubIcon() { return Icon::image(u":github"_s); }
 
@@ -37,20 +101,29 @@ static shared_ptr<Item> makeErrorItem(const QString &error)
     });
 }
 
+static shared_ptr<Item> makeStatusItem(const QString &status)
+{
+    return StandardItem::make(u"status"_s, u"GitHub"_s, status, [] {
+        return Icon::composed(makeGithubIcon(), Icon::standard(Icon::MessageBoxInformation));
+    });
+}
+
 GithubSearchHandler::GithubSearchHandler(const QString &id,
                                          const QString &name,
                                          const QString &description,
                                          const QString &defaultTrigger,
-                                         const RestApi &api)
+                                         const RestApi &api,
+                                         ItemRefresher &refresher)
     : id_(id)
     , name_(name)
     , description_(description)
     , default_trigger_(defaultTrigger)
     , api_(api)
-    , rate_limiter_(api_.rateLimit())
+    , refresher_(refresher)
 {
-    connect(&api_.oauth, &OAuth2::stateChanged,
-            this, [this]{ rate_limiter_.setDelay(api_.rateLimit()); });
+    poll_timer_.setInterval(poll_tick);
+    connect(&poll_timer_, &QTimer::timeout, this, [this]{ pollResultCounts(); });
+    poll_timer_.start();
 }
 
 QString GithubSearchHandler::id() const { return id_; }
@@ -76,41 +149,659 @@ void GithubSearchHandler::setTrigger(const QString &t)
 AsyncItemGenerator GithubSearchHandler::items(QueryContext &ctx)
 {
     try {
-        for (auto page = 1;; ++page)
+        const QString query = ctx;
+        const auto trace_id = trace::newId();
+        trace::Span query_span("query", trace_id, query);
+        const auto result_set = make_shared<ResultSet>(query);
+        QSet<QString> shown;
+        ScrollWindow window(max_query_items);
+
+        // Remembers the page for refinements and returns the items not shown yet
+        const auto take = [&](vector<shared_ptr<GitHubItem>> &page_items) {
+            {
+                lock_guard lock(result_sets_mtx_);
+                const auto n = min(page_items.size(),
+                                   max_cached_items - min(max_cached_items,
+                                                          result_set->items.size()));
+                result_set->items.insert(result_set->items.end(),
+                                         page_items.begin(),
+                                         page_items.begin() + static_cast<ptrdiff_t>(n));
+                trimResultSets();
+            }
+            refresher_.track(page_items);
+
+            vector<shared_ptr<Item>> items;
+            for (auto &item : page_items)
+                if (const auto id = item->id(); !shown.contains(id))
+                {
+                    shown.insert(id);
+                    item->setTraceId(trace_id);
+                    if (window.push(item) && window.compacted() % max_query_items == 0)
+                        DEBG << u"Compacted %1 items of '%2', %3 items alive"_s
+                                    .arg(window.compacted()).arg(query)
+                                    .arg(GitHubItem::liveCount());
+                    items.emplace_back(::move(item));
+                }
+
+            return items;
+        };
+
+        const function<Expected<SearchPage>(const Response &)> page_parser =
+            [this](const Response &r){ return parsePage(r); };
+
+        if (auto local = localResults(query); local)
         {
-            co_await qCoro(rate_limiter_.acquire().get(), &Acquire::granted);
+            DEBG << "Answered locally:" << query;
+            if (!local->empty())
+            {
+                vector<shared_ptr<Item>> items(begin(*local), end(*local));
+                co_yield ::move(items);
+            }
+            co_return;
+        }
 
-            if (!ctx.isValid())
+        // Show what is known locally while the authoritative results are fetched
+        if (auto local = refine(query); !local.empty())
+        {
+            DEBG << "Refined" << local.size() << "cached items locally for" << query;
+            for (const auto &item : local)
+                shown.insert(item->id());
+            vector<shared_ptr<Item>> items(begin(local), end(local));
+            co_yield ::move(items);
+        }
+
+        // Local matches may already be what the user is looking for, hold back the request until
+        // more items are requested
+        if (auto local = localMatches(query); !local.empty())
+        {
+            DEBG << "Matched" << local.size() << "local items for" << query;
+            if (auto items = take(local); !items.empty())
+                co_yield ::move(items);
+        }
+
+        // The result set of a previous run of the query. Its first page is revalidated with a
+        // conditional request. Its items, shown by refine, are not yielded again.
+        shared_ptr<const SearchPage> previous_page;
+        QByteArray previous_etag;
+        {
+            lock_guard lock(result_sets_mtx_);
+            if (const auto it = ranges::find(result_sets_, query, &ResultSet::query);
+                it != result_sets_.end())
+            {
+                previous_page = (*it)->first_page;
+                previous_etag = (*it)->etag;
+            }
+        }
+
+        // Skip queries superseded while the user is still typing. Activated queries (saved and
+        // compound searches) and queries while offline are answered immediately.
+        if (debouncer_.keystroke(query) && !api_.isOffline())
+        {
+            trace::Span span("debounce", trace_id);
+            if (!co_await debouncer_.paused([&ctx]{ return ctx.isValid(); }))
                 co_return;
+        }
+
+        addResultSet(result_set);  // superseded queries would evict the fetched result sets
+
+        // Compound queries (q1 || q2 …). Fetch the queries page by page concurrently and merge.
+        if (auto queries = query.split(u"||"_s, Qt::SkipEmptyParts);
+            queries.size() > 1)
+        {
+            vector<function<QNetworkReply*()>> requests;
+            for (const auto &q : queries)
+                requests.emplace_back([this, q = q.trimmed()]{ return requestSearch(q, 1); });
+
+            for (auto priority = Priority::Interactive;
+                 !requests.empty();
+                 priority = Priority::Scroll)
+            {
+                auto pages = co_await fetchConcurrently(::move(requests), priority,
+                                                        [&ctx]{ return ctx.isValid(); },
+                                                        trace_id);
+                if (!ctx.isValid())
+                    co_return;
+
+                requests.clear();
+                vector<shared_ptr<GitHubItem>> merged;
+                for (auto &var : pages)
+                    if (holds_alternative<QString>(var))
+                    {
+                        vector<std::shared_ptr<albert::Item>> items;
+                        items.push_back(makeErrorItem(get<QString>(var)));
+                        co_yield ::move(items);
+                    }
+                    else
+                    {
+                        auto &page = get<SearchPage>(var);
+                        merged.insert(merged.end(), page.items.begin(), page.items.end());
+                        if (!page.next.isEmpty())
+                            requests.emplace_back([this, url = page.next]
+                                                  { return api_.getLinkData(url); });
+                    }
 
-            unique_ptr<QNetworkReply> reply(requestSearch(ctx, page));
-            DEBG << "Fetch" << reply->request().url();
-            co_await qCoro(reply.get()).waitForFinished();
+                // Ordered per batch (a page of each query), earlier batches have been yielded
+                ranges::stable_sort(merged, greater{}, &GitHubItem::updatedAt);
+                if (auto items = take(merged); !items.empty())  // deduplicates
+                {
+                    trace::instant("yield", trace_id);
+                    co_yield ::move(items);
+                }
+            }
+
+            DEBG << "Fetched all" << shown.size() << "results of" << query;
+            co_return;
+        }
+
+        // Results beyond the search cap are enumerated by creation date ranges. Their order is the
+        // one of the query only if it sorts by creation date.
+        const auto partitionable = !query.contains(u"created:"_s)
+            && query.split(QChar::Space, Qt::SkipEmptyParts).contains(partitionSortQualifier());
 
-            if (const auto var = RestApi::parseJson(*reply);
-                holds_alternative<QJsonDocument>(var))
+        QUrl next;  // cursor of the next page, empty for the first page
+        qint64 fetched = 0;
+        qint64 total_count = 0;
+
+        for (uint page = 1, attempt = 0;;)
+        {
+            auto response = co_await api_.send(
+                [this, query, page, next, etag = page == 1 ? previous_etag : QByteArray{}]{
+                    return next.isEmpty() ? requestSearch(query, page, etag)
+                                          : api_.getLinkData(next);
+                },
+                page == 1 ? Priority::Interactive : Priority::Scroll,
+                [&ctx]{ return ctx.isValid(); },
+                trace_id,
+                page == 1 && next.isEmpty() ? hedgeDelay() : nullopt);
+
+            if (!response || !ctx.isValid())
+                co_return;
+            else if (response->unreachable && api_.isOffline())
             {
-                auto v = get<QJsonDocument>(var)["items"_L1].toArray()
-                         | views::transform([this](const auto &val)
-                                            { return parseItem(val.toObject()); });
-                // TODO: GCC>13 yieling temporaries is fine
-                vector<std::shared_ptr<albert::Item>> items(begin(v), end(v));
+                vector<shared_ptr<Item>> items;
+                items.push_back(makeStatusItem(
+                    Plugin::tr("GitHub is unreachable. Showing cached results only.")));
                 co_yield ::move(items);
+                co_return;
+            }
+
+            debouncer_.roundTrip(response->elapsed);
+            if (page == 1 && attempt == 0)
+                recordFirstPage(*response);
+
+            if (response->error)
+                if (const auto delay = RestApi::retryDelay(*response, attempt); delay)
+                {
+                    DEBG << u"Request failed (%1). Retry %2 in %3 ms."_s
+                                .arg(response->status ? QString::number(response->status)
+                                                      : response->error_string)
+                                .arg(attempt + 1).arg(delay->count());
+
+                    // Show the wait once per page, the user may be staring at an empty list
+                    if (attempt++ == 0)
+                    {
+                        const auto seconds = (delay->count() + 999) / 1000;
+                        const auto text = Plugin::tr("GitHub is busy. Retrying in %1 s…");
+                        vector<shared_ptr<Item>> items;
+                        items.push_back(makeStatusItem(text.arg(seconds)));
+                        co_yield ::move(items);
+                    }
+
+                    QTimer timer;
+                    timer.setSingleShot(true);
+                    timer.start(*delay);
+                    co_await qCoro(&timer, &QTimer::timeout);
+                    continue;  // same page
+                }
+
+            SearchPage search_page;
+            const auto etag = response->header("ETag");
+
+            if (page == 1 && response->status == 304 && previous_page)
+            {
+                DEBG << "First page unchanged, keeping" << previous_page->items.size()
+                     << "items of" << query;
+                search_page = *previous_page;
             }
             else
             {
-                // TODO: GCC>13 yieling temporaries is fine
-                vector<std::shared_ptr<albert::Item>> items;
-                items.push_back(makeErrorItem(get<QString>(var)));
+                trace::Span parse_span("parse", trace_id, QString::number(page));
+                auto var = co_await RestApi::parse<SearchPage>(::move(*response), page_parser);
+                parse_span.end();
+                if (holds_alternative<QString>(var))
+                {
+                    // TODO: GCC>13 yieling temporaries is fine
+                    vector<std::shared_ptr<albert::Item>> items;
+                    items.push_back(makeErrorItem(get<QString>(var)));
+                    co_yield ::move(items);
+                    co_return;
+                }
+
+                search_page = ::move(get<SearchPage>(var));
+
+                if (page == 1 && previous_page)
+                    logRevalidation(query, *previous_page, search_page);
+            }
+
+            if (page == 1)
+            {
+                lock_guard lock(result_sets_mtx_);
+                result_set->first_page = make_shared<const SearchPage>(search_page);
+                result_set->etag = etag.isEmpty() ? previous_etag : etag;
+            }
+
+            fetched += search_page.items.size();
+            total_count = search_page.total_count;
+            next = search_page.next;
+
+            if (auto items = take(search_page.items); !items.empty())
+            {
+                trace::instant("yield", trace_id, QString::number(page));
                 co_yield ::move(items);
+            }
+
+            if (fetched >= total_count)
+            {
+                DEBG << "Fetched all" << fetched << "results of" << query;
                 co_return;
             }
+            else if (next.isEmpty() || search_page.items.empty())
+                break;  // search cap
+            else if (partitionable && total_count > max_search_results)
+                break;  // enumerate by partitions right away, see below
+
+            ++page;
+            attempt = 0;
+        }
+
+        if (total_count <= max_search_results)
+            co_return;
+        else if (!partitionable)
+        {
+            DEBG << "Reached the search cap of" << total_count << "results of" << query;
+            const auto text = Plugin::tr("GitHub shows the first %1 of %2 results. "
+                                         "Add '%3' to show all.");
+            vector<shared_ptr<Item>> items;
+            items.push_back(makeStatusItem(text.arg(max_search_results)
+                                               .arg(total_count)
+                                               .arg(partitionSortQualifier())));
+            co_yield ::move(items);
+            co_return;
         }
+
+        // GitHub caps search results. Enumerate all results by disjoint creation date ranges,
+        // newest first, skipping the items of the first page already shown. A range is resolved
+        // when the user scrolls to it. Its first page tells whether it fits the cap, otherwise
+        // it is split.
+        DEBG << "Partitioning" << total_count << "results of" << query;
+
+        const auto fetchPage = [&](function<QNetworkReply*()> request) {
+            return api_.fetch<SearchPage>(::move(request), Priority::Scroll, page_parser,
+                                          [&ctx]{ return ctx.isValid(); }, trace_id);
+        };
+
+        deque<Partition> partitions{{.from = github_epoch,
+                                     .to = QDate::currentDate(),
+                                     .first_page = SearchPage{.total_count = total_count}}};
+
+        while (!partitions.empty())
+        {
+            auto partition = ::move(partitions.front());
+            partitions.pop_front();
+
+            if (!partition.first_page)
+            {
+                const auto q = partitionQuery(query, partition, partitionSortQualifier());
+                auto var = co_await fetchPage([this, q]{ return requestSearch(q, 1); });
+                if (!ctx.isValid())
+                    co_return;
+                else if (holds_alternative<QString>(var))
+                {
+                    vector<std::shared_ptr<albert::Item>> items;
+                    items.push_back(makeErrorItem(get<QString>(var)));
+                    co_yield ::move(items);
+                    co_return;
+                }
+                partition.first_page = ::move(get<SearchPage>(var));
+            }
+
+            if (partition.first_page->total_count > max_search_results
+                && partition.from < partition.to)
+            {
+                const auto children = splitPartition(partition,
+                                                     partition.first_page->total_count);
+                partitions.insert(partitions.begin(), children.begin(), children.end());
+                continue;
+            }
+
+            // The range fits the cap, page through it
+            for (auto search_page = ::move(*partition.first_page);;)
+            {
+                if (auto items = take(search_page.items); !items.empty())
+                {
+                    trace::instant("yield", trace_id);
+                    co_yield ::move(items);
+                }
+
+                if (search_page.next.isEmpty())
+                    break;
+
+                auto var = co_await fetchPage([this, url = search_page.next]
+                                              { return api_.getLinkData(url); });
+                if (!ctx.isValid())
+                    co_return;
+                else if (holds_alternative<QString>(var))
+                {
+                    vector<std::shared_ptr<albert::Item>> items;
+                    items.push_back(makeErrorItem(get<QString>(var)));
+                    co_yield ::move(items);
+                    co_return;
+                }
+                search_page = ::move(get<SearchPage>(var));
+            }
+        }
+
+        DEBG << "Fetched all" << shown.size() << "partitioned results of" << query;
+
     } catch (...) {
         CRIT << "EXCEP";
     }
 }
 
+Expected<SearchPage> GithubSearchHandler::parsePage(const Response &response) const
+{
+    auto var = [&] -> Expected<SearchPage> {
+#if defined(GITHUB_USE_SIMDJSON)
+        if (!response.error)
+            return parseSearchPage(response.body);
+#endif
+        if (const auto json = RestApi::parseJson(response);
+            holds_alternative<QJsonDocument>(json))
+        {
+            const auto &doc = get<QJsonDocument>(json);
+            auto v = doc["items"_L1].toArray()
+                     | views::transform([this](const auto &val){ return parseItem(val.toObject()); });
+            return SearchPage{.items = {begin(v), end(v)},
+                              .total_count = doc["total_count"_L1].toInteger()};
+        }
+        else
+            return get<QString>(json);
+    }();
+
+    if (auto *page = get_if<SearchPage>(&var))
+        if (const auto links = RestApi::links(response); links.contains(u"next"_s))
+            page->next = links.at(u"next"_s);
+
+    return var;
+}
+
+QCoro::Task<vector<Expected<SearchPage>>>
+GithubSearchHandler::fetchConcurrently(vector<function<QNetworkReply*()>> requests,
+                                       Priority priority,
+                                       function<bool()> alive,
+                                       quint64 trace_id) const
+{
+    // Tasks start eagerly, the scheduler limits the concurrency
+    vector<QCoro::Task<Expected<SearchPage>>> tasks;
+    for (auto &request : requests)
+        tasks.emplace_back(api_.fetch<SearchPage>(::move(request), priority,
+                                                  [this](const Response &r)
+                                                  { return parsePage(r); },
+                                                  alive, trace_id));
+
+    vector<Expected<SearchPage>> pages;
+    for (auto &task : tasks)
+        pages.emplace_back(co_await ::move(task));
+
+    if (alive && !alive())
+        co_return vector<Expected<SearchPage>>{};
+    co_return pages;
+}
+
+optional<chrono::milliseconds> GithubSearchHandler::hedgeDelay() const
+{
+    lock_guard lock(mtx);
+    if (first_page_latencies_.size() < min_latency_samples)
+        return {};
+
+    vector<chrono::milliseconds> v(first_page_latencies_.begin(), first_page_latencies_.end());
+    const auto p95 = v.begin() + static_cast<ptrdiff_t>(v.size() * 95 / 100);
+    ranges::nth_element(v, p95);
+    return max<chrono::milliseconds>(*p95, min_hedge_delay);
+}
+
+void GithubSearchHandler::recordFirstPage(const Response &response)
+{
+    lock_guard lock(mtx);
+
+    ++first_pages_;
+    if (response.hedged)
+    {
+        ++hedged_first_pages_;
+        DEBG << u"Hedged first page after p95 latency, hedge rate %1 % (%2 of %3)"_s
+                    .arg(100. * hedged_first_pages_ / first_pages_, 0, 'f', 1)
+                    .arg(hedged_first_pages_).arg(first_pages_);
+    }
+
+    if (!response.error)  // failures answer fast, they would lower the percentile
+    {
+        first_page_latencies_.push_back(response.elapsed);
+        if (first_page_latencies_.size() > latency_samples)
+            first_page_latencies_.pop_front();
+    }
+}
+
+void GithubSearchHandler::logRevalidation(const QString &query,
+                                          const SearchPage &previous,
+                                          const SearchPage &current)
+{
+    // Live items are shared by identity, changed fields have been updated in place already
+    QSet<QString> previous_ids;
+    for (const auto &item : previous.items)
+        previous_ids.insert(item->id());
+
+    qsizetype kept = 0;
+    for (const auto &item : current.items)
+        kept += previous_ids.remove(item->id()) ? 1 : 0;
+
+    DEBG << u"Revalidated first page of '%1': %2 kept, %3 inserted, %4 removed"_s
+                .arg(query).arg(kept).arg(qsizetype(current.items.size()) - kept)
+                .arg(previous_ids.size());
+}
+
+optional<vector<shared_ptr<GitHubItem>>> GithubSearchHandler::localResults(const QString &) const
+{ return {}; }
+
+vector<shared_ptr<GitHubItem>> GithubSearchHandler::localMatches(const QString &) const
+{ return {}; }
+
+QString GithubSearchHandler::partitionSortQualifier() const { return u"sort:created-desc"_s; }
+
+namespace
+{
+
+struct ParsedQuery
+{
+    QString text;            // free text, lower case
+    QStringList qualifiers;  // lower case
+};
+
+optional<ParsedQuery> parseQuery(const QString &query)
+{
+    static const QRegularExpression re_qualifier(uR"(^-?[a-z-]+:\S+$)"_s);
+
+    if (query.contains(u'"'))
+        return {};  // phrases are not worth the effort
+
+    ParsedQuery p;
+    QStringList terms;
+    for (const auto &token : query.split(QChar::Space, Qt::SkipEmptyParts))
+        if (re_qualifier.match(token).hasMatch())
+            p.qualifiers << token.toLower();
+        else if (token == u"OR" || token == u"AND" || token == u"NOT")
+            return {};  // boolean expressions can not be narrowed trivially
+        else
+            terms << token.toLower();
+    p.text = terms.join(QChar::Space);
+    return p;
+}
+
+}
+
+vector<shared_ptr<GitHubItem>> GithubSearchHandler::refine(const QString &query) const
+{
+    const auto current = parseQuery(query);
+    if (!current)
+        return {};
+
+    const auto terms = current->text.split(QChar::Space, Qt::SkipEmptyParts);
+
+    lock_guard lock(result_sets_mtx_);
+    for (const auto &result_set : result_sets_)  // most recent first
+    {
+        if (!result_set->first_page || result_set->items.empty())
+            continue;  // not fetched (yet)
+
+        const auto previous = parseQuery(result_set->query);
+        if (!previous
+            || !current->text.startsWith(previous->text)
+            || !ranges::all_of(previous->qualifiers,
+                               [&](const auto &q){ return current->qualifiers.contains(q); }))
+            continue;
+
+        vector<pair<QString, QString>> added;
+        for (const auto &q : current->qualifiers)
+            if (!previous->qualifiers.contains(q))
+            {
+                if (q.startsWith(u'-'))
+                    return {};  // negations are not evaluated locally
+                added.emplace_back(q.section(u':', 0, 0), q.section(u':', 1));
+            }
+
+        vector<shared_ptr<GitHubItem>> refined;
+        for (const auto &item : result_set->items)
+        {
+            bool match = item->containsAll(terms);  // does not undo compaction
+
+            for (const auto &[key, value] : added)
+                if (!match)
+                    break;
+                else if (const auto m = item->matches(key, value); m)
+                    match = *m;
+                else
+                    return {};  // qualifier can not be evaluated locally
+
+            if (match)
+                refined.push_back(item);
+        }
+        return refined;
+    }
+    return {};
+}
+
+void GithubSearchHandler::addResultSet(shared_ptr<ResultSet> result_set)
+{
+    lock_guard lock(result_sets_mtx_);
+    erase_if(result_sets_, [&](const auto &rs){ return rs->query == result_set->query; });
+    result_sets_.push_front(::move(result_set));
+    trimResultSets();
+}
+
+void GithubSearchHandler::trimResultSets()
+{
+    // Evict the least recent result sets beyond the budgets, keep the most recent one
+    size_t count = 0;
+    for (const auto &rs : result_sets_)
+        count += rs->items.size();
+
+    while (result_sets_.size() > 1
+           && (result_sets_.size() > max_result_sets || count > max_cached_items))
+    {
+        count -= result_sets_.back()->items.size();
+        result_sets_.pop_back();
+    }
+}
+
+optional<qint64> GithubSearchHandler::resultCount(const QString &query) const
+{
+    lock_guard lock(mtx);
+    if (const auto it = result_counts_.find(query); it != result_counts_.end())
+        return it->second.count;
+    return {};
+}
+
+QCoro::Task<> GithubSearchHandler::pollResultCounts()
+{
+    if (polling_)
+        co_return;
+    polling_ = true;
+
+    vector<pair<QString, ResultCount>> due;
+    {
+        const auto now = chrono::steady_clock::now();
+        lock_guard lock(mtx);
+
+        // Follow the saved searches. Compound searches are not counted, counts do not add up.
+        map<QString, ResultCount> counts;
+        for (const auto &[_, q] : saved_searches_)
+            if (q.contains(u"||"_s))
+                continue;
+            else if (auto node = result_counts_.extract(q); node)
+                counts.insert(::move(node));
+            else
+                counts.emplace(q, ResultCount{.interval = min_poll_interval, .due = now});
+        result_counts_ = ::move(counts);
+
+        for (const auto &[q, rc] : result_counts_)
+            if (rc.due <= now && due.size() < max_polls_per_tick)
+                due.emplace_back(q, rc);
+    }
+
+    bool changed = false;
+    for (auto &[q, rc] : due)
+    {
+        const auto response = co_await api_.send([this, q = q, etag = rc.etag]
+                                                 { return requestCount(q, etag); },
+                                                 Priority::Background);
+
+        // Poll less often while nothing changes. Tiny documents, parsed in place.
+        if (response->status == 304)
+            rc.interval = min<chrono::seconds>(rc.interval * 2, max_poll_interval);
+
+        else if (const auto var = RestApi::parseJson(*response); holds_alternative<QString>(var))
+        {
+            WARN << "Failed to poll result count of" << q << get<QString>(var);
+            rc.interval = max_poll_interval;
+        }
+
+        else if (const auto count = get<QJsonDocument>(var)["total_count"_L1].toInteger();
+                 count != rc.count)
+        {
+            rc.count = count;
+            rc.etag = response->header("ETag");
+            rc.interval = min_poll_interval;
+            changed = true;
+        }
+
+        else
+        {
+            rc.etag = response->header("ETag");
+            rc.interval = min<chrono::seconds>(rc.interval * 2, max_poll_interval);
+        }
+
+        rc.due = chrono::steady_clock::now() + rc.interval;
+
+        lock_guard lock(mtx);
+        if (auto it = result_counts_.find(q); it != result_counts_.end())  // still saved?
+            it->second = rc;
+    }
+
+    polling_ = false;
+
+    if (changed)
+        emit resultCountsChanged();
+}
+
 vector<pair<QString, QString>> GithubSearchHandler::savedSearches() const
 {
     lock_guard lock(mtx);
@@ -128,43 +819,80 @@ void GithubSearchHandler::setSavedSearches(const vector<pair<QString, QString>>
         notify = true;
     }
     if (notify)
+    {
         emit savedSearchesChanged();
+        QMetaObject::invokeMethod(this, [this]{ pollResultCounts(); }, Qt::QueuedConnection);
+    }
 }
 
 //--------------------------------------------------------------------------------------------------
 
-UserSearchHandler::UserSearchHandler(const github::RestApi &api):
+UserSearchHandler::UserSearchHandler(const github::RestApi &api,
+                                     ItemRefresher &refresher,
+                                     const MemberDirectory &directory):
     GithubSearchHandler(u"github.users"_s,
                         Plugin::tr("GitHub users"),
                         Plugin::tr("Search GitHub users"),
                         u"ghu"_s,
-                        api)
+                        api,
+                        refresher),
+    directory_(directory)
 {}
 
-QNetworkReply *UserSearchHandler::requestSearch(const QString &query, uint page) const
-{ return api_.searchUsers(query, 10, page); }
+QNetworkReply *UserSearchHandler::requestSearch(const QString &query, uint page,
+                                                const QByteArray &etag) const
+{ return api_.searchUsers(query, 10, page, etag); }
 
-shared_ptr<Item> UserSearchHandler::parseItem(const QJsonObject &o) const
+QNetworkReply *UserSearchHandler::requestCount(const QString &query, const QByteArray &etag) const
+{ return api_.searchUsers(query, 1, 1, etag); }
+
+shared_ptr<GitHubItem> UserSearchHandler::parseItem(const QJsonObject &o) const
 { return UserItem::fromJson(o); }
 
+#if defined(GITHUB_USE_SIMDJSON)
+variant<SearchPage, QString> UserSearchHandler::parseSearchPage(const QByteArray &json) const
+{ return simd::parseSearchPage<UserItem>(json); }
+#endif
+
 vector<pair<QString, QString>> UserSearchHandler::defaultSearches() const { return {}; }
 
+QString UserSearchHandler::partitionSortQualifier() const { return u"sort:joined-desc"_s; }
+
+vector<shared_ptr<GitHubItem>> UserSearchHandler::localMatches(const QString &query) const
+{
+    // Plain text only, qualifiers can not be evaluated against the directory
+    if (query.contains(u':') || query.contains(u"||"_s))
+        return {};
+    auto v = directory_.match(query.trimmed());
+    return {make_move_iterator(v.begin()), make_move_iterator(v.end())};
+}
+
 //--------------------------------------------------------------------------------------------------
 
-RepoSearchHandler::RepoSearchHandler(const github::RestApi &api):
+RepoSearchHandler::RepoSearchHandler(const github::RestApi &api, ItemRefresher &refresher):
     GithubSearchHandler(u"github.repositories"_s,
                         Plugin::tr("GitHub repositories"),
                         Plugin::tr("Search GitHub repositories"),
                         u"ghr"_s,
-                        api)
+                        api,
+                        refresher)
 {}
 
-QNetworkReply *RepoSearchHandler::requestSearch(const QString &query, uint page) const
-{ return api_.searchRepositories(query, 10, page); }
+QNetworkReply *RepoSearchHandler::requestSearch(const QString &query, uint page,
+                                                const QByteArray &etag) const
+{ return api_.searchRepositories(query, 10, page, etag); }
 
-shared_ptr<Item> RepoSearchHandler::parseItem(const QJsonObject &o) const
+QNetworkReply *RepoSearchHandler::requestCount(const QString &query, const QByteArray &etag) const
+{ return api_.searchRepositories(query, 1, 1, etag); }
+
+shared_ptr<GitHubItem> RepoSearchHandler::parseItem(const QJsonObject &o) const
 { return RepositoryItem::fromJson(o); }
 
+#if defined(GITHUB_USE_SIMDJSON)
+variant<SearchPage, QString> RepoSearchHandler::parseSearchPage(const QByteArray &json) const
+{ return simd::parseSearchPage<RepositoryItem>(json); }
+#endif
+
 vector<pair<QString, QString>> RepoSearchHandler::defaultSearches() const
 {
     return {
@@ -185,20 +913,33 @@ vector<pair<QString, QString>> RepoSearchHandler::defaultSearches() const
 
 //--------------------------------------------------------------------------------------------------
 
-IssueSearchHandler::IssueSearchHandler(const github::RestApi &api):
+IssueSearchHandler::IssueSearchHandler(const github::RestApi &api,
+                                       ItemRefresher &refresher,
+                                       const IssueIndex &index):
     GithubSearchHandler(u"github.issues"_s,
                         Plugin::tr("GitHub issues"),
                         Plugin::tr("Search GitHub issues"),
                         u"ghi"_s,
-                        api)
+                        api,
+                        refresher),
+    index_(index)
 {}
 
-QNetworkReply *IssueSearchHandler::requestSearch(const QString &query, uint page) const
-{ return api_.searchIssues(query, 10, page); }
+QNetworkReply *IssueSearchHandler::requestSearch(const QString &query, uint page,
+                                                 const QByteArray &etag) const
+{ return api_.searchIssues(query, 10, page, etag); }
 
-shared_ptr<Item> IssueSearchHandler::parseItem(const QJsonObject &o) const
+QNetworkReply *IssueSearchHandler::requestCount(const QString &query, const QByteArray &etag) const
+{ return api_.searchIssues(query, 1, 1, etag); }
+
+shared_ptr<GitHubItem> IssueSearchHandler::parseItem(const QJsonObject &o) const
 { return IssueItem::fromJson(o); }
 
+#if defined(GITHUB_USE_SIMDJSON)
+variant<SearchPage, QString> IssueSearchHandler::parseSearchPage(const QByteArray &json) const
+{ return simd::parseSearchPage<IssueItem>(json); }
+#endif
+
 vector<pair<QString, QString>> IssueSearchHandler::defaultSearches() const
 {
     return {
@@ -213,3 +954,149 @@ vector<pair<QString, QString>> IssueSearchHandler::defaultSearches() const
         {Plugin::tr("Recent activity"),        u"involves:@me"_s}
     };
 }
+
+optional<vector<shared_ptr<GitHubItem>>>
+IssueSearchHandler::localResults(const QString &query) const
+{
+    // Answer queries scoped to pinned repositories from the local index. Compound queries are
+    // not evaluated locally.
+    if (query.contains(u"||"_s))
+        return {};
+
+    const auto parsed = parseQuery(query);
+    if (!parsed)
+        return {};
+
+    QStringList repositories;
+    vector<pair<QString, QString>> qualifiers;
+    for (const auto &q : parsed->qualifiers)
+        if (q.startsWith(u'-'))
+            return {};
+        else if (const auto key = q.section(u':', 0, 0); key == u"repo")
+            repositories << q.section(u':', 1);
+        else
+            qualifiers.emplace_back(key, q.section(u':', 1));
+
+    if (repositories.isEmpty()
+        || !ranges::all_of(repositories, [this](const auto &r){ return index_.isIndexed(r); }))
+        return {};
+
+    vector<shared_ptr<GitHubItem>> results;
+    for (auto &item : index_.match(repositories, parsed->text))
+    {
+        bool match = true;
+        for (const auto &[key, value] : qualifiers)
+            if (const auto m = item->matches(key, value); !m)
+                return {};  // qualifier can not be evaluated locally
+            else if (!*m)
+            {
+                match = false;
+                break;
+            }
+
+        if (match)
+            results.emplace_back(::move(item));
+    }
+    return results;
+}
+
+//--------------------------------------------------------------------------------------------------
+
+static shared_ptr<Item> makeFileItem(const QString &repository,
+                                     const QString &sha,
+                                     const QString &path)
+{
+    const auto url = u"https://github.com/%1/blob/HEAD/%2"_s.arg(repository, path);
+    const auto permalink = u"https://github.com/%1/blob/%2/%3"_s.arg(repository, sha, path);
+
+    vector<Action> actions;
+    actions.emplace_back(u"open"_s, Plugin::tr("Show on GitHub"), [url]{ openUrl(url); });
+    actions.emplace_back(u"permalink"_s, Plugin::tr("Copy permalink"),
+                         [permalink]{ setClipboardText(permalink); });
+
+    return StandardItem::make(u"%1/%2"_s.arg(repository, path), path.section(u'/', -1), path,
+                              makeGithubIcon, ::move(actions));
+}
+
+FileSearchHandler::FileSearchHandler(TreeIndex &index) : index_(index) {}
+
+QString FileSearchHandler::id() const { return u"github.files"_s; }
+
+QString FileSearchHandler::name() const { return Plugin::tr("GitHub files"); }
+
+QString FileSearchHandler::description() const
+{ return Plugin::tr("Find files in GitHub repositories"); }
+
+QString FileSearchHandler::defaultTrigger() const { return u"ghf "_s; }
+
+AsyncItemGenerator FileSearchHandler::items(QueryContext &ctx)
+{
+    const QString query = ctx;
+    const auto repository = query.section(u' ', 0, 0, QString::SectionSkipEmpty);
+    const auto text = query.section(u' ', 1, -1, QString::SectionSkipEmpty);
+
+    if (repository.count(u'/') != 1 || repository.endsWith(u'/'))
+    {
+        vector<shared_ptr<Item>> items;
+        items.push_back(makeStatusItem(Plugin::tr("Type owner/repo followed by a path.")));
+        co_yield ::move(items);
+        co_return;
+    }
+
+    const auto trace_id = trace::newId();
+    trace::Span query_span("query", trace_id, query);
+
+    // Only revalidations hit the network, skip queries superseded while the user is still typing
+    if (debouncer_.keystroke(query) && !index_.isFresh(repository))
+    {
+        trace::Span span("debounce", trace_id);
+        if (!co_await debouncer_.paused([&ctx]{ return ctx.isValid(); }))
+            co_return;
+    }
+
+    auto var = co_await index_.tree(repository, [&ctx]{ return ctx.isValid(); }, trace_id);
+    if (!ctx.isValid())
+        co_return;
+    else if (holds_alternative<QString>(var))
+    {
+        vector<shared_ptr<Item>> items;
+        items.push_back(makeErrorItem(get<QString>(var)));
+        co_yield ::move(items);
+        co_return;
+    }
+    const auto tree = get<shared_ptr<const TreeIndex::Tree>>(var);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // Match on the mapped paths, materialize items page by page
+    vector<pair<size_t, double>> matches;
+    {
+        trace::Span span("match", trace_id);
+        Matcher matcher(text, {.fuzzy = true});
+        for (size_t i = 0; i < tree->size(); ++i)
+            if (text.isEmpty())
+                matches.emplace_back(i, 0.);
+            else if (auto m = matcher.match(tree->path(i)); m)
+                matches.emplace_back(i, m.score());
+        ranges::stable_sort(matches, greater{}, &pair<size_t, double>::second);  // keeps tree order
+    }
+
+    DEBG << u"Matched %1 of %2 files of %3 in %4 ms"_s
+                .arg(matches.size()).arg(tree->size()).arg(repository).arg(timer.elapsed());
+
+    static const size_t page_size = 50;
+    const auto sha = tree->sha();
+    for (size_t first = 0; first < matches.size() && ctx.isValid(); first += page_size)
+    {
+        trace::Span span("build", trace_id);
+        vector<shared_ptr<Item>> items;
+        for (size_t i = first; i < min(first + page_size, matches.size()); ++i)
+            items.push_back(makeFileItem(repository, sha,
+                                         QStringView(tree->path(matches[i].first)).toString()));
+        span.end();
+
+        trace::instant("yield", trace_id);
+        co_yield ::move(items);
+    }
+}
@@ -1,15 +1,31 @@
 // Copyright (c) 2025-2025 Manuel Schneider
 
 #pragma once
+#include "debouncer.h"
+#include "github.h"
+#include "scheduler.h"
+#include <QCoroTask>
 #include <QObject>
+#include <QTimer>
 #include <albert/asyncgeneratorqueryhandler.h>
-#include <albert/ratelimiter.h>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
 #include <mutex>
+#include <optional>
+#include <variant>
+class GitHubItem;
+class IssueIndex;
+class ItemRefresher;
+class MemberDirectory;
+struct SearchPage;
+class TreeIndex;
 class Plugin;
 class QJsonArray;
 class QNetworkReply;
 namespace albert { class Item; }
-namespace github { class RestApi; }
 
 class GithubSearchHandler : public QObject, public albert::AsyncGeneratorQueryHandler
 {
@@ -21,7 +37,8 @@ public:
                         const QString &name,
                         const QString &description,
                         const QString &defaultTrigger,
-                        const github::RestApi&);
+                        const github::RestApi&,
+                        ItemRefresher&);
 
     QString id() const override;
     QString name() const override;
@@ -35,9 +52,50 @@ public:
     std::vector<std::pair<QString, QString>> savedSearches() const;
     void setSavedSearches(const std::vector<std::pair<QString, QString>>&);
 
+    /// Returns the polled result count of the saved search `query` if known. Thread-safe.
+    std::optional<qint64> resultCount(const QString &query) const;
+
     virtual std::vector<std::pair<QString, QString>> defaultSearches() const = 0;
-    virtual QNetworkReply *requestSearch(const QString &query, uint page) const = 0;
-    virtual std::shared_ptr<albert::Item> parseItem(const QJsonObject &) const = 0;
+
+    /// Requests the `page` of `query`, conditional if `etag` is not empty.
+    virtual QNetworkReply *requestSearch(const QString &query, uint page,
+                                         const QByteArray &etag = {}) const = 0;
+
+    /// Requests a single result of `query`, conditional if `etag` is not empty.
+    virtual QNetworkReply *requestCount(const QString &query, const QByteArray &etag) const = 0;
+    virtual std::shared_ptr<GitHubItem> parseItem(const QJsonObject &) const = 0;
+#if defined(GITHUB_USE_SIMDJSON)
+    virtual std::variant<SearchPage, QString> parseSearchPage(const QByteArray &) const = 0;
+#endif
+
+    /// Parses a search response or returns an error message. Thread-safe.
+    github::Expected<SearchPage> parsePage(const github::Response &) const;
+
+    /// Sends `requests` concurrently within the request budget and parses their replies.
+    /// Returns no pages if `alive` returned false meanwhile.
+    QCoro::Task<std::vector<github::Expected<SearchPage>>>
+    fetchConcurrently(std::vector<std::function<QNetworkReply*()>> requests,
+                      github::RequestScheduler::Priority priority,
+                      std::function<bool()> alive = {},
+                      quint64 trace_id = 0) const;
+
+    /// The qualifier that sorts by creation date, newest first.
+    /// Results of queries sorted by it are enumerated beyond the search cap.
+    virtual QString partitionSortQualifier() const;
+
+    /// Returns the results of `query` if it can be answered locally, without any request.
+    virtual std::optional<std::vector<std::shared_ptr<GitHubItem>>>
+    localResults(const QString &query) const;
+
+    /// Returns local items matching `query` to show before the remote results, which are then
+    /// fetched only if more items are requested.
+    virtual std::vector<std::shared_ptr<GitHubItem>> localMatches(const QString &query) const;
+
+    /// Returns the locally matching items of a recent result set `query` narrows.
+    ///
+    /// Narrowing means extending the free text or adding qualifiers that the items can evaluate
+    /// locally, see GitHubItem::matches.
+    std::vector<std::shared_ptr<GitHubItem>> refine(const QString &query) const;
 
 protected:
     const QString id_;
@@ -45,16 +103,56 @@ protected:
     const QString description_;
     const QString default_trigger_;
     const github::RestApi &api_;
-    albert::detail::RateLimiter rate_limiter_;
+    ItemRefresher &refresher_;
+    github::TypingDebouncer debouncer_;
 
     // Things accessesd by main and query threads
     mutable std::mutex mtx;
     QString trigger_;
     std::vector<std::pair<QString, QString>> saved_searches_;
 
+    // Recent result sets, accessed by query threads
+    struct ResultSet
+    {
+        const QString query;
+        std::vector<std::shared_ptr<GitHubItem>> items;  // guarded by result_sets_mtx_
+
+        // Revalidates the first page when the query is run again, guarded by result_sets_mtx_
+        std::shared_ptr<const SearchPage> first_page;
+        QByteArray etag;  // of the first page
+    };
+    void addResultSet(std::shared_ptr<ResultSet>);
+    void trimResultSets();  // requires result_sets_mtx_
+    static void logRevalidation(const QString &query,
+                                const SearchPage &previous,
+                                const SearchPage &current);
+    mutable std::mutex result_sets_mtx_;
+    std::list<std::shared_ptr<ResultSet>> result_sets_;  // most recent first
+
+    // Result counts of the saved searches, polled in the background
+    struct ResultCount
+    {
+        std::optional<qint64> count;
+        QByteArray etag;
+        std::chrono::seconds interval;  // adapts to the rate of change
+        std::chrono::steady_clock::time_point due;
+    };
+    QCoro::Task<> pollResultCounts();
+    std::map<QString, ResultCount> result_counts_;  // by query, guarded by mtx
+    QTimer poll_timer_;
+    bool polling_ = false;
+
+    // Latencies of first pages, used to hedge slow first page requests
+    std::optional<std::chrono::milliseconds> hedgeDelay() const;
+    void recordFirstPage(const github::Response &);
+    std::deque<std::chrono::milliseconds> first_page_latencies_;  // newest last, guarded by mtx
+    uint first_pages_ = 0;         // guarded by mtx
+    uint hedged_first_pages_ = 0;  // guarded by mtx
+
 signals:
 
     void savedSearchesChanged();
+    void resultCountsChanged();
 
     friend class GithubQueryExecution;
 
@@ -64,19 +162,33 @@ signals:
 class UserSearchHandler : public GithubSearchHandler
 {
 public:
-    UserSearchHandler(const github::RestApi&);
-    QNetworkReply *requestSearch(const QString &query, uint page) const override;
-    std::shared_ptr<albert::Item> parseItem(const QJsonObject &) const override;
+    UserSearchHandler(const github::RestApi&, ItemRefresher&, const MemberDirectory&);
+    QNetworkReply *requestSearch(const QString &query, uint page,
+                                 const QByteArray &etag) const override;
+    QNetworkReply *requestCount(const QString &query, const QByteArray &etag) const override;
+    std::shared_ptr<GitHubItem> parseItem(const QJsonObject &) const override;
+#if defined(GITHUB_USE_SIMDJSON)
+    std::variant<SearchPage, QString> parseSearchPage(const QByteArray &) const override;
+#endif
     std::vector<std::pair<QString, QString>> defaultSearches() const override;
+    QString partitionSortQualifier() const override;
+    std::vector<std::shared_ptr<GitHubItem>> localMatches(const QString &query) const override;
+private:
+    const MemberDirectory &directory_;
 };
 
 
 class RepoSearchHandler : public GithubSearchHandler
 {
 public:
-    RepoSearchHandler(const github::RestApi&);
-    QNetworkReply *requestSearch(const QString &query, uint page) const override;
-    std::shared_ptr<albert::Item> parseItem(const QJsonObject &) const override;
+    RepoSearchHandler(const github::RestApi&, ItemRefresher&);
+    QNetworkReply *requestSearch(const QString &query, uint page,
+                                 const QByteArray &etag) const override;
+    QNetworkReply *requestCount(const QString &query, const QByteArray &etag) const override;
+    std::shared_ptr<GitHubItem> parseItem(const QJsonObject &) const override;
+#if defined(GITHUB_USE_SIMDJSON)
+    std::variant<SearchPage, QString> parseSearchPage(const QByteArray &) const override;
+#endif
     std::vector<std::pair<QString, QString>> defaultSearches() const override;
 };
 
@@ -84,8 +196,37 @@ public:
 class IssueSearchHandler : public GithubSearchHandler
 {
 public:
-    IssueSearchHandler(const github::RestApi&);
-    QNetworkReply *requestSearch(const QString &query, uint page) const override;
-    std::shared_ptr<albert::Item> parseItem(const QJsonObject &) const override;
+    IssueSearchHandler(const github::RestApi&, ItemRefresher&, const IssueIndex&);
+    QNetworkReply *requestSearch(const QString &query, uint page,
+                                 const QByteArray &etag) const override;
+    QNetworkReply *requestCount(const QString &query, const QByteArray &etag) const override;
+    std::shared_ptr<GitHubItem> parseItem(const QJsonObject &) const override;
+#if defined(GITHUB_USE_SIMDJSON)
+    std::variant<SearchPage, QString> parseSearchPage(const QByteArray &) const override;
+#endif
     std::vector<std::pair<QString, QString>> defaultSearches() const override;
+    std::optional<std::vector<std::shared_ptr<GitHubItem>>>
+    localResults(const QString &query) const override;
+private:
+    const IssueIndex &index_;
+};
+
+
+///
+/// Finds files of a repository by fuzzy matching the paths of its tree index.
+///
+/// The query is the repository (owner/repo) followed by the path to match.
+///
+class FileSearchHandler : public albert::AsyncGeneratorQueryHandler
+{
+public:
+    FileSearchHandler(TreeIndex&);
+    QString id() const override;
+    QString name() const override;
+    QString description() const override;
+    QString defaultTrigger() const override;
+    albert::AsyncItemGenerator items(albert::QueryContext &) override;
+private:
+    TreeIndex &index_;
+    github::TypingDebouncer debouncer_;
 };
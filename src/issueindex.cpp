@@ -0,0 +1,255 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "github.h"
+#include "issueindex.h"
+#include "itemstore.h"
+#include "items.h"
+#include "scheduler.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QStringTokenizer>
+#include <albert/app.h>
+#include <albert/logging.h>
+#include <albert/matcher.h>
+#include <algorithm>
+#include <ranges>
+using namespace Qt::StringLiterals;
+using namespace albert;
+using namespace github;
+using namespace std;
+
+namespace
+{
+static const auto sync_interval = 10min;
+
+enum Meta { ETag, Since };
+
+QString indexFilePath(const QString &repository)
+{
+    return QDir(App::cacheLocation() / "github" / "issues")
+        .filePath(QString(repository).replace(u'/', u'.') + u".bin"_s);
+}
+}
+
+IssueIndex::IssueIndex(const RestApi &api) : api_(api)
+{
+    sync_timer_.setInterval(sync_interval);
+    connect(&sync_timer_, &QTimer::timeout, this, [this]{ sync(); });
+}
+
+IssueIndex::~IssueIndex() = default;
+
+QStringList IssueIndex::repositories() const
+{
+    QStringList repositories;
+    for (const auto &[repository, _] : repositories_)
+        repositories << repository;
+    return repositories;
+}
+
+void IssueIndex::setRepositories(const QStringList &repositories)
+{
+    map<QString, Repository> old;
+    swap(old, repositories_);
+
+    for (const auto &repository : repositories)
+    {
+        const auto r = repository.trimmed().toLower();
+        if (r.count(u'/') != 1)
+            WARN << "Invalid repository:" << repository;
+        else if (auto node = old.extract(r); node)
+            repositories_.insert(::move(node));
+        else
+            load(r);
+    }
+
+    {
+        lock_guard lock(mutex_);
+        erase_if(snapshots_, [this](const auto &s){ return !repositories_.contains(s.first); });
+    }
+
+    if (repositories_.empty())
+        sync_timer_.stop();
+    else
+    {
+        sync_timer_.start();
+        sync();
+    }
+}
+
+bool IssueIndex::isIndexed(const QString &repository) const
+{
+    lock_guard lock(mutex_);
+    return snapshots_.contains(repository.toLower());
+}
+
+vector<shared_ptr<IssueItem>> IssueIndex::match(const QStringList &repositories,
+                                                const QString &text) const
+{
+    vector<shared_ptr<const ItemStore>> snapshots;
+    {
+        lock_guard lock(mutex_);
+        for (const auto &repository : repositories)
+            if (const auto it = snapshots_.find(repository.toLower()); it != snapshots_.end())
+                snapshots.emplace_back(it->second);
+    }
+
+    // Match on the mapped strings, materialize hits only
+    using F = ItemStore::IssueFields;
+    vector<pair<shared_ptr<IssueItem>, double>> matches;
+    Matcher matcher(text, {.fuzzy = true});
+    for (const auto &store : snapshots)
+        for (size_t i = 0; i < store->size(); ++i)
+        {
+            double score = 0.;
+            if (!text.isEmpty())
+            {
+                if (auto m = matcher.match(store->string(i, F::Title)); m)
+                    score = max(score, m.score());
+                if (auto m = matcher.match(u"#%1"_s.arg(store->number(i, F::Number))); m)
+                    score = max(score, m.score());
+                for (const auto label : QStringTokenizer(store->string(i, F::Labels), u'\n'))
+                    if (auto m = matcher.match(label.toString()); m)
+                        score = max(score, m.score());
+                if (score == 0.)
+                    continue;
+            }
+            matches.emplace_back(IssueItem::fromData(store->issueData(i)), score);
+        }
+
+    ranges::stable_sort(matches, greater{}, &pair<shared_ptr<IssueItem>, double>::second);
+
+    auto v = matches | views::keys;
+    return {begin(v), end(v)};
+}
+
+QCoro::Task<> IssueIndex::sync()
+{
+    if (syncing_)
+    {
+        resync_ = true;  // e.g. repositories added meanwhile
+        co_return;
+    }
+    syncing_ = true;
+
+    do
+    {
+        resync_ = false;
+        for (const auto &repository : repositories())
+            co_await sync(repository);
+    }
+    while (resync_);  // revalidating the synced ones is cheap, the requests are conditional
+
+    syncing_ = false;
+}
+
+QCoro::Task<> IssueIndex::sync(QString repository)
+{
+    if (!repositories_.contains(repository))
+        co_return;
+
+    const auto since = repositories_.at(repository).since;
+    const auto etag = repositories_.at(repository).etag;
+
+    QByteArray new_etag;
+    QString new_since = since;
+    map<qint64, IssueItem::Data> changed;
+
+    for (QUrl next;;)
+    {
+        auto response = co_await api_.send(
+            [this, repository, since, etag, next] {
+                return next.isEmpty() ? api_.repositoryIssues(repository, since, etag)
+                                      : api_.getLinkData(next);
+            },
+            RequestScheduler::Priority::Background);
+
+        if (response->status == 304)
+        {
+            DEBG << "Issue index up to date:" << repository;
+            co_return;
+        }
+
+        if (next.isEmpty())
+            new_etag = response->header("ETag");
+
+        const auto links = RestApi::links(*response);
+        const auto var = co_await RestApi::parse<QJsonDocument>(::move(*response),
+                                                                &RestApi::parseJson);
+        if (holds_alternative<QString>(var))
+        {
+            WARN << "Failed to sync issue index of" << repository << get<QString>(var);
+            co_return;
+        }
+
+        for (const auto &value : get<QJsonDocument>(var).array())
+        {
+            auto issue = IssueItem::dataFromJson(value.toObject());
+            new_since = max(new_since, issue.updated_at);  // ISO 8601 UTC
+            changed.insert_or_assign(issue.number, ::move(issue));
+        }
+
+        if (links.contains(u"next"_s))
+            next = links.at(u"next"_s);
+        else
+            break;
+    }
+
+    auto it = repositories_.find(repository);
+    if (it == repositories_.end())  // no longer pinned
+        co_return;
+
+    shared_ptr<const ItemStore> store;
+    {
+        lock_guard lock(mutex_);
+        if (const auto s = snapshots_.find(repository); s != snapshots_.end())
+            store = s->second;
+    }
+
+    // Merge, keeping unchanged records
+    const auto changed_count = changed.size();
+    auto issues = ::move(changed);
+    if (store)
+        for (size_t i = 0; i < store->size(); ++i)
+            if (const auto n = store->number(i, ItemStore::IssueFields::Number); !issues.contains(n))
+                issues.emplace(n, store->issueData(i));
+
+    vector<const IssueItem::Data*> sorted;
+    sorted.reserve(issues.size());
+    for (const auto &[_, issue] : issues)
+        sorted.emplace_back(&issue);
+    ranges::sort(sorted, greater{}, [](const auto *d){ return d->updated_at; });
+
+    ItemStore::Writer writer;
+    for (const auto *issue : sorted)
+        writer.add(*issue);
+    writer.setMeta({QString::fromUtf8(new_etag), new_since});
+
+    // The file is replaced atomically, mappings of the previous snapshot stay valid
+    if (!writer.write(indexFilePath(repository)))
+        co_return;
+
+    DEBG << "Synced" << changed_count << "issues of" << repository;
+    load(repository);
+}
+
+void IssueIndex::load(const QString &repository)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    auto &r = repositories_[repository];
+    auto store = ItemStore::open(indexFilePath(repository));
+    if (!store)
+        return;
+
+    r.etag = store->meta(ETag).toUtf8();
+    r.since = store->meta(Since);
+    DEBG << u"Mapped issue index of %1 (%2 issues) in %3 ms"_s
+                .arg(repository).arg(store->size()).arg(timer.elapsed());
+
+    lock_guard lock(mutex_);
+    snapshots_[repository] = ::move(store);
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#pragma once
+#include <QCoroTask>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+class IssueItem;
+namespace github { class RestApi; class ItemStore; }
+
+///
+/// Local index of the issues and pull requests of pinned repositories.
+///
+/// Synchronizes incrementally using the `since` parameter and conditional requests and persists
+/// the index as memory-mapped ItemStore in the cache location. isIndexed and match are
+/// thread-safe.
+///
+class IssueIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    IssueIndex(const github::RestApi &);
+    ~IssueIndex() override;
+
+    /// The pinned repositories (owner/repo, lower case).
+    QStringList repositories() const;
+
+    /// Sets the pinned repositories, loads their indexes from disk and synchronizes them.
+    void setRepositories(const QStringList &);
+
+    /// Returns true if `repository` is pinned and its index is available.
+    bool isIndexed(const QString &repository) const;
+
+    /// Fuzzy matches the issues of `repositories` by title, number and labels.
+    /// Returns all issues if `text` is empty. Most recently updated first on equal score.
+    std::vector<std::shared_ptr<IssueItem>> match(const QStringList &repositories,
+                                                  const QString &text) const;
+
+private:
+
+    struct Repository
+    {
+        QByteArray etag;
+        QString since;
+    };
+
+    QCoro::Task<> sync();
+    QCoro::Task<> sync(QString repository);
+    void load(const QString &repository);
+
+    const github::RestApi &api_;
+    std::map<QString, Repository> repositories_;  // main thread only
+    QTimer sync_timer_;
+    bool syncing_ = false;
+    bool resync_ = false;  // sync requested while syncing
+
+    // Accessed by query threads
+    mutable std::mutex mutex_;
+    std::map<QString, std::shared_ptr<const github::ItemStore>> snapshots_;  // by repository
+
+};
@@ -1,22 +1,35 @@
 // // Copyright (c) 2025-2025 Manuel Schneider
 
 #include "items.h"
+#include "tracing.h"
 #include <QCoreApplication>
 #include <QDir>
 #include <QFile>
+#include <QGuiApplication>
+#include <QHash>
+#include <QImageReader>
+#include <QJsonArray>
+#include <QPointer>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 #include <albert/app.h>
 #include <albert/download.h>
 #include <albert/icon.h>
 #include <albert/logging.h>
 #include <albert/networkutil.h>
 #include <albert/systemutil.h>
+#include <ranges>
 using namespace Qt::StringLiterals;
 using namespace albert;
+using namespace github;
 using namespace std;
 
 inline static unique_ptr<Icon> placeHolderIcon()
 { return Icon::iconified(Icon::image(u":github"_s)); }
 
+static atomic<size_t> live_items = 0;
+
 GitHubItem::GitHubItem(const QString &id,
                        const QString &title,
                        const QString &description,
@@ -29,172 +42,581 @@ GitHubItem::GitHubItem(const QString &id,
     remote_icon_url_(remote_icon_url)
 {
     moveToThread(qApp->thread());  // Signals wont work with affinity to a thread w/o loop
+    ++live_items;
 }
 
-GitHubItem::~GitHubItem() = default;
+GitHubItem::~GitHubItem() { --live_items; }
+
+size_t GitHubItem::liveCount() { return live_items; }
 
 QString GitHubItem::id() const { return id_; }
 
-QString GitHubItem::text() const { return title_; }
+QString GitHubItem::text() const
+{
+    lock_guard lock(data_mutex_);
+    return title_;
+}
+
+QString GitHubItem::subtext() const
+{
+    lock_guard lock(data_mutex_);
+    if (description_.isNull())
+        description_ = makeDescription();  // rehydrate
+    return description_;
+}
+
+void GitHubItem::compact()
+{
+    lock_guard lock(data_mutex_);
+    description_ = QString();
+}
+
+bool GitHubItem::containsAll(const QStringList &terms) const
+{
+    lock_guard lock(data_mutex_);
+    const auto description = description_.isNull() ? makeDescription() : description_;
+    return ranges::all_of(terms, [&](const auto &t){
+        return title_.contains(t, Qt::CaseInsensitive)
+               || description.contains(t, Qt::CaseInsensitive);
+    });
+}
+
+void GitHubItem::setText(const QString &title, const QString &description)
+{
+    {
+        lock_guard lock(data_mutex_);
+        if (title_ == title && description_ == description)
+            return;
+        title_ = title;
+        description_ = description;
+    }
+    dataChanged();
+}
+
+namespace
+{
+// Pixel sizes of the pre-scaled avatars for standard and high density displays
+static const array<int, 2> avatar_sizes{64, 128};
 
-QString GitHubItem::subtext() const { return description_; }
+// Decoding is bursty when scrolling, keep it off the global pool used by the query handlers
+struct AvatarThreadPool : QThreadPool { AvatarThreadPool() { setMaxThreadCount(2); } };
+static AvatarThreadPool avatar_thread_pool;
+
+QString scaledAvatarPath(const QDir &dir, const QString &name, int size)
+{ return dir.filePath(u"%1_%2.png"_s.arg(name).arg(size)); }
+
+// Items waiting for their avatar to be scaled, by avatar name. Items often share an avatar, e.g.
+// the issues of an author. One scale per avatar is in flight.
+static mutex scaling_mutex;
+static QHash<QString, vector<QPointer<const GitHubItem>>> scaling;
+
+bool isScaled(const QDir &dir, const QString &name)
+{
+    return ranges::all_of(avatar_sizes, [&](int size){
+        return QFile::exists(scaledAvatarPath(dir, name, size));
+    });
+}
+
+// Decodes once and stores losslessly compressed variants in all avatar sizes. Returns false on
+// failure. Removes sources that can not be decoded.
+bool scaleAvatar(const QString &source, const QDir &dir, const QString &name)
+{
+    if (isScaled(dir, name))  // the source has been removed
+        return true;
+
+    QImageReader reader(source);
+    const auto max_size = avatar_sizes.back();
+    if (const auto size = reader.size(); size.width() > max_size || size.height() > max_size)
+        reader.setScaledSize(size.scaled(max_size, max_size, Qt::KeepAspectRatio));  // cheaper
+
+    const auto image = reader.read();
+    if (image.isNull())
+    {
+        if (!QFile::exists(source))  // not a decoding failure
+            return isScaled(dir, name);
+
+        WARN << "Failed to decode avatar:" << reader.errorString();
+        QFile::remove(source);
+        return false;
+    }
+
+    for (const auto size : avatar_sizes)
+    {
+        QSaveFile file(scaledAvatarPath(dir, name, size));
+        if (!file.open(QIODevice::WriteOnly)
+            || !image.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+                    .save(&file, "PNG")
+            || !file.commit())
+        {
+            WARN << "Failed to write avatar:" << file.errorString();
+            return false;
+        }
+    }
+
+    QFile::remove(source);
+    return true;
+}
+}
 
 unique_ptr<Icon> GitHubItem::icon() const
 {
-    if (download_)
+    if (pending_ || failed_)
         return placeHolderIcon();
 
-    else if (const auto icon_path = QDir(App::cacheLocation() / "github" / "icons")
-                                        .filePath(QUrl(remote_icon_url_).fileName() + u".jpg"_s);
-             QFile::exists(icon_path))
-        return Icon::iconified(Icon::image(icon_path));
+    const QDir dir(App::cacheLocation() / "github" / "icons");
+    const auto name = QUrl(remote_icon_url_).fileName();
+    const auto size = qGuiApp->devicePixelRatio() > 1. ? avatar_sizes.back() : avatar_sizes.front();
+
+    if (const auto path = scaledAvatarPath(dir, name, size); QFile::exists(path))
+        return Icon::iconified(Icon::image(path));
+
+    pending_ = true;
+
+    const auto trace_id = trace_id_.load();
+    const auto scale = [this, dir, name, trace_id](const QString &source)
+    {
+        {
+            lock_guard lock(scaling_mutex);
+            auto &waiting = scaling[name];
+            waiting.emplace_back(this);
+            if (waiting.size() > 1)
+                return;  // in flight
+        }
+
+        QtConcurrent::run(&avatar_thread_pool, [=] {
+            trace::Span span("icon scale", trace_id, name);
+            return scaleAvatar(source, dir, name);
+        })
+            .then(qApp, [name](bool scaled) {
+                vector<QPointer<const GitHubItem>> waiting;
+                {
+                    lock_guard lock(scaling_mutex);
+                    waiting = scaling.take(name);
+                }
+
+                for (const auto &item : waiting)
+                    if (item)
+                    {
+                        item->pending_ = false;
+                        if (scaled)
+                            item->dataChanged();
+                        else
+                            item->failed_ = true;  // keeps showing the placeholder
+                    }
+            });
+    };
+
+    if (const auto path = dir.filePath(name + u".jpg"_s); QFile::exists(path))
+        scale(path);
 
     else
     {
-        download_ = Download::unique(remote_icon_url_, icon_path);
+        download_ = Download::unique(remote_icon_url_, path);
 
-        connect(download_.get(), &Download::finished, this, [=, this]{
+        connect(download_.get(), &Download::finished, this,
+                [=, this, begin = trace::now()]{
+            trace::complete("icon download", trace_id, begin, trace::now(), remote_icon_url_);
             if (const auto error = download_->error();
                 error.isNull())
-                icon_ = Icon::iconified(Icon::image(download_->path()));
+                scale(download_->path());
             else
             {
                 WARN << "Failed to download icon:" << error;
-                icon_ = Icon::image(u":github"_s);
+                pending_ = false;
+                failed_ = true;  // keeps showing the placeholder
             }
 
-            dataChanged();
             download_.reset();
         });
-
-        return placeHolderIcon();
     }
+
+    return placeHolderIcon();
 }
 
 vector<Action> GitHubItem::actions() const
 {
-    return {{u"open"_s, tr("Show on GitHub"), [this] { openUrl(html_url_); }}};
+    return {{u"open"_s, tr("Show on GitHub"), [this] { activated(); openUrl(html_url_); }}};
+}
+
+static function<void(const GitHubItem &)> activation_observer;
+
+void GitHubItem::setActivationObserver(function<void(const GitHubItem &)> observer)
+{ activation_observer = ::move(observer); }
+
+void GitHubItem::setTraceId(quint64 id) { trace_id_ = id; }
+
+void GitHubItem::activated() const
+{
+    if (activation_observer)
+        activation_observer(*this);
+}
+
+optional<bool> GitHubItem::matches(QStringView, QStringView) const { return {}; }
+
+QString GitHubItem::nodeId() const { return {}; }
+
+QString GitHubItem::updatedAt() const { return {}; }
+
+static bool equalsCi(QStringView a, QStringView b)
+{ return a.compare(b, Qt::CaseInsensitive) == 0; }
+
+// Returns the live item of type T with `id` or creates one. Repeated results of any query or
+// handler share one object, i.e. its formatted text, its icon and its refresh state. Newer data
+// is applied to the live item on the main thread. Thread-safe.
+template<class T>
+static shared_ptr<T> intern(const QString &id, const typename T::Data &d)
+{
+    static mutex mtx;
+    static QHash<QString, weak_ptr<T>> items;
+    static qsizetype purge_size = 1024;
+
+    shared_ptr<T> item;
+    {
+        lock_guard lock(mtx);
+        auto &weak = items[id];
+        if (item = weak.lock(); !item)
+        {
+            weak = item = make_shared<T>(d);
+
+            if (items.size() > purge_size)
+            {
+                items.removeIf([](const auto &it){ return it.value().expired(); });
+                purge_size = max<qsizetype>(1024, items.size() * 2);
+            }
+            return item;
+        }
+    }
+
+    if constexpr (is_same_v<T, UserItem>)  // search results lack the name, keep a known one
+    {
+        if (!d.name.isEmpty() && item->data() != d)
+            QMetaObject::invokeMethod(item.get(), [item, d]{ item->setData(d); });
+    }
+    else if (const auto current = item->data();
+             current != d && current.updated_at <= d.updated_at)
+        QMetaObject::invokeMethod(item.get(), [item, d]{ item->setData(d); });
+
+    return item;
 }
 
 // -------------------------------------------------------------------------------------------------
 
+static QString makeUserDescription(const UserItem::Data &d)
+{ return d.name.isEmpty() ? d.type : u"%1 · %2"_s.arg(d.name, d.type); }
+
+UserItem::UserItem(const Data &d) :
+    GitHubItem(d.login, d.login, makeUserDescription(d), d.html_url, d.avatar_url),
+    data_(d)
+{}
+
+QString UserItem::makeDescription() const { return makeUserDescription(data_); }
+
+shared_ptr<UserItem> UserItem::fromData(const Data &d) { return intern<UserItem>(d.login, d); }
+
 shared_ptr<UserItem> UserItem::fromJson(const QJsonObject &o)
 {
-    const auto id = o["login"_L1].toString();
+    return fromData({
+        .login = o["login"_L1].toString(),
+        .type = o["type"_L1].toString(),
+        .html_url = o["html_url"_L1].toString(),
+        .avatar_url = o["avatar_url"_L1].toString()
+    });
+}
 
-    return make_shared<UserItem>(
-        id,
-        id,
-        o["type"_L1].toString(),
-        o["html_url"_L1].toString(),
-        o["avatar_url"_L1].toString());
+UserItem::Data UserItem::data() const
+{
+    lock_guard lock(data_mutex_);
+    return data_;
+}
+
+void UserItem::setData(const Data &d)
+{
+    {
+        lock_guard lock(data_mutex_);
+        data_ = d;
+    }
+    setText(d.login, makeUserDescription(d));
+}
+
+optional<bool> UserItem::matches(QStringView key, QStringView value) const
+{
+    lock_guard lock(data_mutex_);
+
+    if (key == u"type")
+    {
+        if (equalsCi(value, u"user"))
+            return data_.type == u"User";
+        else if (equalsCi(value, u"org"))
+            return data_.type == u"Organization";
+    }
+    return {};
 }
 
 // -------------------------------------------------------------------------------------------------
 
-static QString makeRepositoryDescription(const QJsonObject &o)
+static QString makeRepositoryDescription(const RepositoryItem::Data &d)
 {
     QStringList tokens;
-    if (const auto v = o["stargazers_count"_L1].toInt(); v)
-        tokens << u"✨"_s + QString::number(v);
-    if (const auto v = o["forks_count"_L1].toInt(); v)
-        tokens << u"🍴"_s + QString::number(v);
-    if (const auto v = o["open_issues_count"_L1].toInt(); v)
-        tokens << u"⚠️"_s + QString::number(v);
+    if (d.stargazers_count)
+        tokens << u"✨"_s + QString::number(d.stargazers_count);
+    if (d.forks_count)
+        tokens << u"🍴"_s + QString::number(d.forks_count);
+    if (d.open_issues_count)
+        tokens << u"⚠️"_s + QString::number(d.open_issues_count);
 
     if (!tokens.isEmpty())
         tokens = {tokens.join(QChar::Space)};
 
-    if (const auto d = o["description"_L1].toString();
-        !d.isEmpty())
-        tokens << d;
+    if (!d.description.isEmpty())
+        tokens << d.description;
 
     return tokens.join(u" · "_s);
 }
 
+RepositoryItem::RepositoryItem(const Data &d) :
+    GitHubItem(d.full_name, d.full_name, makeRepositoryDescription(d), d.html_url, d.avatar_url),
+    data_(d)
+{}
+
+QString RepositoryItem::makeDescription() const { return makeRepositoryDescription(data_); }
+
+shared_ptr<RepositoryItem> RepositoryItem::fromData(const Data &d)
+{ return intern<RepositoryItem>(d.full_name, d); }
+
 shared_ptr<RepositoryItem> RepositoryItem::fromJson(const QJsonObject &o)
 {
-    const auto id = o["full_name"_L1].toString();
+    return fromData({
+        .node_id = o["node_id"_L1].toString(),
+        .full_name = o["full_name"_L1].toString(),
+        .description = o["description"_L1].toString(),
+        .html_url = o["html_url"_L1].toString(),
+        .avatar_url = o["owner"_L1]["avatar_url"_L1].toString(),
+        .language = o["language"_L1].toString(),
+        .updated_at = o["updated_at"_L1].toString(),
+        .stargazers_count = o["stargazers_count"_L1].toInteger(),
+        .forks_count = o["forks_count"_L1].toInteger(),
+        .open_issues_count = o["open_issues_count"_L1].toInteger(),
+        .has_issues = o["has_issues"_L1].toBool(),
+        .has_discussions = o["has_discussions"_L1].toBool(),
+        .has_wiki = o["has_wiki"_L1].toBool(),
+        .archived = o["archived"_L1].toBool(),
+        .fork = o["fork"_L1].toBool()
+    });
+}
 
-    auto item = make_shared<RepositoryItem>(
-        id,
-        id,
-        makeRepositoryDescription(o),
-        o["html_url"_L1].toString(),
-        o["owner"_L1]["avatar_url"_L1].toString());
+RepositoryItem::Data RepositoryItem::data() const
+{
+    lock_guard lock(data_mutex_);
+    return data_;
+}
 
-    item->has_issues = o["has_issues"_L1].toBool();
-    item->has_discussions = o["has_discussions"_L1].toBool();
-    item->has_wiki = o["has_wiki"_L1].toBool();
+void RepositoryItem::setData(const Data &d)
+{
+    {
+        lock_guard lock(data_mutex_);
+        data_ = d;
+    }
+    setText(d.full_name, makeRepositoryDescription(d));
+}
 
-    return item;
+QString RepositoryItem::nodeId() const
+{
+    lock_guard lock(data_mutex_);
+    return data_.node_id;
+}
+
+QString RepositoryItem::updatedAt() const
+{
+    lock_guard lock(data_mutex_);
+    return data_.updated_at;
 }
 
 vector<Action> RepositoryItem::actions() const
 {
     auto actions = GitHubItem::actions();
+    const auto d = data();
 
-    if (has_issues)
+    if (d.has_issues)
     {
         actions.emplace_back(u"oi"_s, GitHubItem::tr("Open issues"),
-                             [this]{ openUrl(html_url_ + u"/issues"_s); });
+                             [this]{ activated(); openUrl(html_url_ + u"/issues"_s); });
 
         actions.emplace_back(u"op"_s, GitHubItem::tr("Open pull requests"),
-                             [this]{ openUrl(html_url_ + u"/pulls"_s); });
+                             [this]{ activated(); openUrl(html_url_ + u"/pulls"_s); });
     }
 
-    if (has_discussions)
+    if (d.has_discussions)
         actions.emplace_back(u"od"_s, GitHubItem::tr("Open discussions"),
-                             [this]{ openUrl(html_url_ + u"/discussions"_s); });
+                             [this]{ activated(); openUrl(html_url_ + u"/discussions"_s); });
 
-    if (has_wiki)
+    if (d.has_wiki)
         actions.emplace_back(u"ow"_s, GitHubItem::tr("Open wiki"),
-                             [this]{ openUrl(html_url_ + u"/wiki"_s); });
+                             [this]{ activated(); openUrl(html_url_ + u"/wiki"_s); });
 
     return actions;
 }
 
+optional<bool> RepositoryItem::matches(QStringView key, QStringView value) const
+{
+    lock_guard lock(data_mutex_);
+
+    if (key == u"language")
+        return equalsCi(value, data_.language);
+
+    else if (key == u"archived")
+    {
+        if (value == u"true")
+            return data_.archived;
+        else if (value == u"false")
+            return !data_.archived;
+    }
+
+    else if (key == u"fork")
+    {
+        if (value == u"true")
+            return true;  // forks are included, not required
+        else if (value == u"only")
+            return data_.fork;
+    }
+
+    return {};
+}
+
 // -------------------------------------------------------------------------------------------------
 
-static QString makeIssueDescription(const QJsonObject &o, const QString id)
+const array<QLatin1String, 8> IssueItem::reaction_keys{{"+1"_L1, "-1"_L1, "laugh"_L1,
+                                                         "hooray"_L1, "confused"_L1, "heart"_L1,
+                                                         "rocket"_L1, "eyes"_L1}};
+
+static QString makeIssueId(const IssueItem::Data &d)
+{ return u"%1#%2"_s.arg(d.repository).arg(d.number); }
+
+static QString makeIssueDescription(const IssueItem::Data &d)
 {
+    static const array<QString, 8> emojis{u"👍"_s, u"👎"_s, u"😄"_s, u"🎉"_s,
+                                          u"😕"_s, u"❤️"_s, u"🚀"_s, u"👀"_s};
+
+    QStringList reaction_tokens;
+    for (size_t i = 0; i < d.reactions.size(); ++i)
+        if (const auto c = d.reactions[i]; c)
+            reaction_tokens << u"%1%2"_s.arg(emojis[i]).arg(c);
+
+    if (reaction_tokens.isEmpty())
+        return u"%1 · %2"_s.arg(d.state.toUpper(), makeIssueId(d));
+    else
+        return u"%1 · %2 · %3"_s.arg(d.state.toUpper(),
+                                     reaction_tokens.join(QChar::Space),
+                                     makeIssueId(d));
+}
+
+IssueItem::IssueItem(const Data &d) :
+    GitHubItem(makeIssueId(d), d.title, makeIssueDescription(d), d.html_url, d.avatar_url),
+    data_(d)
+{}
+
+QString IssueItem::makeDescription() const { return makeIssueDescription(data_); }
+
+shared_ptr<IssueItem> IssueItem::fromData(const Data &d)
+{ return intern<IssueItem>(makeIssueId(d), d); }
+
+IssueItem::Data IssueItem::dataFromJson(const QJsonObject &o)
+{
+    Data d{
+        .repository = o["repository_url"_L1].toString().section(u'/', -2),
+        .node_id = o["node_id"_L1].toString(),
+        .number = o["number"_L1].toInteger(),
+        .title = o["title"_L1].toString(),
+        .state = o["state"_L1].toString(),
+        .html_url = o["html_url"_L1].toString(),
+        .avatar_url = o["user"_L1]["avatar_url"_L1].toString(),
+        .updated_at = o["updated_at"_L1].toString(),
+        .pull_request = o.contains("pull_request"_L1)
+    };
+
+    for (const auto &label : o["labels"_L1].toArray())
+        d.labels << label.toObject()["name"_L1].toString();
+
     if (const auto reactions = o["reactions"_L1];
         reactions["total_count"_L1].toInt())
+        for (size_t i = 0; i < reaction_keys.size(); ++i)
+            d.reactions[i] = reactions[reaction_keys[i]].toInteger();
+
+    return d;
+}
+
+shared_ptr<IssueItem> IssueItem::fromJson(const QJsonObject &o)
+{ return fromData(dataFromJson(o)); }
+
+IssueItem::Data IssueItem::data() const
+{
+    lock_guard lock(data_mutex_);
+    return data_;
+}
+
+void IssueItem::setData(const Data &d)
+{
     {
-        static const array<pair<QLatin1String, QString>, 8>
-            reactions_map{{{"+1"_L1, u"👍"_s},
-                           {"-1"_L1, u"👎"_s},
-                           {"laugh"_L1, u"😄"_s},
-                           {"hooray"_L1, u"🎉"_s},
-                           {"confused"_L1, u"😕"_s},
-                           {"heart"_L1, u"❤️"_s},
-                           {"rocket"_L1, u"🚀"_s},
-                           {"eyes"_L1, u"👀"_s}}};
-
-        QStringList reaction_tokens;
-        for (const auto &[key, emoji] : reactions_map)
-            if (const auto c = reactions[key].toInt(); c)
-                reaction_tokens << u"%1%2"_s.arg(emoji).arg(c);
-
-        return u"%1 · %2 · %3"_s.arg(o["state"_L1].toString().toUpper(),
-                                     reaction_tokens.join(QChar::Space),
-                                     id);
+        lock_guard lock(data_mutex_);
+        data_ = d;
     }
-    else
-        return u"%1 · %2"_s.arg(o["state"_L1].toString().toUpper(), id);
+    setText(d.title, makeIssueDescription(d));
 }
 
-shared_ptr<IssueItem> IssueItem::fromJson(const QJsonObject &o)
+QString IssueItem::nodeId() const
+{
+    lock_guard lock(data_mutex_);
+    return data_.node_id;
+}
+
+QString IssueItem::updatedAt() const
+{
+    lock_guard lock(data_mutex_);
+    return data_.updated_at;
+}
+
+optional<bool> IssueItem::matches(QStringView key, QStringView value) const
 {
-    const auto id = u"%1#%2"_s
-                        .arg(o["repository_url"_L1].toString().section(u'/', -2))
-                        .arg(o["number"_L1].toInteger());
+    lock_guard lock(data_mutex_);
+
+    if (key == u"is" || key == u"state" || key == u"type")
+    {
+        if (key != u"type" && (value == u"open" || value == u"closed"))
+            return data_.state == value;
+        else if (key != u"state" && value == u"issue")
+            return !data_.pull_request;
+        else if (key != u"state" && value == u"pr")
+            return data_.pull_request;
+    }
 
-    return make_shared<IssueItem>(
-        id,
-        o["title"_L1].toString(),
-        makeIssueDescription(o, id),
-        o["html_url"_L1].toString(),
-        o["user"_L1]["avatar_url"_L1].toString());
+    else if (key == u"label")  // label:a,b matches either
+        return ranges::any_of(value.split(u',', Qt::SkipEmptyParts), [&](QStringView v){
+            return ranges::any_of(data_.labels, [&](const auto &l){ return equalsCi(l, v); });
+        });
+
+    else if (key == u"repo")
+        return equalsCi(data_.repository, value);
+
+    return {};
+}
+
+// -------------------------------------------------------------------------------------------------
+
+ScrollWindow::ScrollWindow(size_t size) : size_(size) {}
+
+bool ScrollWindow::push(const shared_ptr<GitHubItem> &item)
+{
+    recent_.emplace_back(item);
+    if (recent_.size() <= size_)
+        return false;
+
+    const auto leaving = recent_.front().lock();
+    recent_.pop_front();
+    if (!leaving)
+        return false;
+
+    leaving->compact();
+    ++compacted_;
+    return true;
 }
 
+size_t ScrollWindow::compacted() const { return compacted_; }
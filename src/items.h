@@ -2,8 +2,16 @@
 
 #pragma once
 #include <QJsonObject>
+#include <QStringList>
+#include <QUrl>
 #include <albert/item.h>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <vector>
 namespace albert {
 class Icon;
@@ -29,42 +37,205 @@ public:
     std::unique_ptr<albert::Icon> icon() const override;
     std::vector<albert::Action> actions() const override;
 
+    /// Returns whether this item satisfies the search qualifier `key`:`value` or `std::nullopt`
+    /// if the qualifier can not be evaluated locally.
+    virtual std::optional<bool> matches(QStringView key, QStringView value) const;
+
+    /// The GraphQL node id or an empty string if the item can not be refreshed.
+    virtual QString nodeId() const;
+
+    /// The ISO 8601 time of the last update or an empty string if unknown.
+    virtual QString updatedAt() const;
+
+    /// Sets the function called on the main thread when an action of any item is activated.
+    static void setActivationObserver(std::function<void(const GitHubItem &)>);
+
+    /// Correlates the icon spans of this item with the trace of query `id`. Thread-safe.
+    void setTraceId(quint64 id);
+
+    /// Releases the formatted description of an item scrolled out of view. It is rehydrated on
+    /// demand. Icons are not retained, they are loaded from the scaled avatars. Thread-safe.
+    void compact();
+
+    /// Returns whether each of `terms` is contained in text or subtext (case-insensitive). Does
+    /// not rehydrate a compacted item. Thread-safe.
+    bool containsAll(const QStringList &terms) const;
+
+    /// The number of items alive. Thread-safe.
+    static size_t liveCount();
+
 protected:
 
+    /// Formats the description from the data of the derived class. Requires data_mutex_.
+    virtual QString makeDescription() const = 0;
+
+    /// Notifies the activation observer. To be called by actions.
+    void activated() const;
+
+    /// Updates text and subtext and notifies observers if they changed. Main thread only.
+    void setText(const QString &title, const QString &description);
+
+    mutable std::mutex data_mutex_;  // guards mutable data of this and derived classes
     const QString id_;
-    const QString title_;
-    const QString description_;
+    QString title_;
+    mutable QString description_;  // null if compacted
     const QString html_url_;
     const QString remote_icon_url_;
-    mutable std::unique_ptr<albert::Icon> icon_;
     mutable std::shared_ptr<albert::Download> download_;
+    mutable bool pending_ = false;  // downloading or scaling
+    mutable bool failed_ = false;   // no avatar this session, shows the placeholder
+    std::atomic<quint64> trace_id_ = 0;  // the query that showed this item last
 };
 
 
 class UserItem : public GitHubItem
 {
 public:
-    using GitHubItem::GitHubItem;
+    struct Data
+    {
+        QString login;
+        QString type;
+        QString html_url;
+        QString avatar_url;
+        QString name;  // if known, search results do not have it
+        bool operator==(const Data &) const = default;
+    };
+
+    UserItem(const Data &);
+
+    /// Returns the live item of the user or creates one. Updates a live item if `data` has the
+    /// name of the user.
+    static std::shared_ptr<UserItem> fromData(const Data &);
     static std::shared_ptr<UserItem> fromJson(const QJsonObject &);
+    std::optional<bool> matches(QStringView key, QStringView value) const override;
+    Data data() const;
+    void setData(const Data &);  // main thread only
+
+private:
+    QString makeDescription() const override;
+    Data data_;
 };
 
 
 class RepositoryItem : public GitHubItem
 {
 public:
-    using GitHubItem::GitHubItem;
+    struct Data
+    {
+        QString node_id;
+        QString full_name;
+        QString description;
+        QString html_url;
+        QString avatar_url;  // owner
+        QString language;
+        QString updated_at;  // ISO 8601
+        qint64 stargazers_count = 0;
+        qint64 forks_count = 0;
+        qint64 open_issues_count = 0;
+        bool has_issues = false;
+        bool has_discussions = false;
+        bool has_wiki = false;
+        bool archived = false;
+        bool fork = false;
+        bool operator==(const Data &) const = default;
+    };
+
+    RepositoryItem(const Data &);
+
+    /// Returns the live item of the repository or creates one. Updates a live item if `data` is
+    /// not older.
+    static std::shared_ptr<RepositoryItem> fromData(const Data &);
     static std::shared_ptr<RepositoryItem> fromJson(const QJsonObject &);
     std::vector<albert::Action> actions() const override;
+    std::optional<bool> matches(QStringView key, QStringView value) const override;
+    QString nodeId() const override;
+    QString updatedAt() const override;
+    Data data() const;
+    void setData(const Data &);  // main thread only
+
 private:
-    bool has_issues;
-    bool has_discussions;
-    bool has_wiki;
+    QString makeDescription() const override;
+    Data data_;
 };
 
 
 class IssueItem : public GitHubItem
 {
 public:
-    using GitHubItem::GitHubItem;
+    /// Reaction counts in the order of the GitHub reactions object
+    /// (+1, -1, laugh, hooray, confused, heart, rocket, eyes).
+    using Reactions = std::array<qint64, 8>;
+
+    struct Data
+    {
+        QString repository;  // owner/repo
+        QString node_id;
+        qint64 number = 0;
+        QString title;
+        QString state;
+        QString html_url;
+        QString avatar_url;  // user
+        QString updated_at;  // ISO 8601
+        QStringList labels;
+        Reactions reactions{};
+        bool pull_request = false;
+        bool operator==(const Data &) const = default;
+    };
+
+    IssueItem(const Data &);
+
+    /// Returns the live item of the issue or creates one. Updates a live item if `data` is not
+    /// older.
+    static std::shared_ptr<IssueItem> fromData(const Data &);
     static std::shared_ptr<IssueItem> fromJson(const QJsonObject &);
+    static Data dataFromJson(const QJsonObject &);
+    std::optional<bool> matches(QStringView key, QStringView value) const override;
+    QString nodeId() const override;
+    QString updatedAt() const override;
+    Data data() const;
+    void setData(const Data &);  // main thread only
+
+    /// The keys of the reactions in the order of ``Reactions``.
+    static const std::array<QLatin1String, 8> reaction_keys;
+
+private:
+    QString makeDescription() const override;
+    Data data_;
+};
+
+
+/// A page of search results.
+struct SearchPage
+{
+    std::vector<std::shared_ptr<GitHubItem>> items;
+    qint64 total_count = 0;
+    QUrl next;  // empty on the last page
+};
+
+
+///
+/// The items of an infinite scroll session most recently shown, in the order shown.
+///
+/// Results only grow. The items scrolled past the window are compacted, they are rehydrated if
+/// scrolled into view again.
+///
+class ScrollWindow
+{
+public:
+
+    explicit ScrollWindow(size_t size);
+
+    /// Appends `item` and compacts the item leaving the window, if any. Returns true if an item
+    /// has been compacted.
+    bool push(const std::shared_ptr<GitHubItem> &item);
+
+    /// The number of items compacted so far.
+    size_t compacted() const;
+
+private:
+
+    const size_t size_;
+    std::deque<std::weak_ptr<GitHubItem>> recent_;  // most recent last
+    size_t compacted_ = 0;
+
 };
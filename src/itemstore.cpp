@@ -0,0 +1,269 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "itemstore.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <albert/logging.h>
+#include <cstring>
+using namespace Qt::StringLiterals;
+using namespace github;
+using namespace std;
+
+namespace
+{
+static constexpr char magic[4] = {'G', 'H', 'I', 'S'};
+static_assert(is_trivially_copyable_v<ItemStore::Record>);
+static_assert(is_trivially_copyable_v<ItemStore::Header>);
+static_assert(sizeof(ItemStore::Header) % alignof(ItemStore::Record) == 0);
+static_assert(sizeof(ItemStore::Record) % alignof(char16_t) == 0);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+ItemStore::StringRef ItemStore::Writer::string(const QString &s)
+{
+    if (s.isEmpty())
+        return {0, 0};
+    else if (const auto it = interned_.constFind(s); it != interned_.constEnd())
+        return *it;
+
+    const StringRef ref{static_cast<quint32>(pool_.size()), static_cast<quint32>(s.size())};
+    pool_.append(s);
+    interned_.insert(s, ref);
+    return ref;
+}
+
+size_t ItemStore::Writer::add(const UserItem::Data &d)
+{
+    Record r{.type = Type::User};
+    r.strings[UserFields::Login] = string(d.login);
+    r.strings[UserFields::Type] = string(d.type);
+    r.strings[UserFields::HtmlUrl] = string(d.html_url);
+    r.strings[UserFields::AvatarUrl] = string(d.avatar_url);
+    r.strings[UserFields::Name] = string(d.name);
+    records_.push_back(r);
+    return records_.size() - 1;
+}
+
+size_t ItemStore::Writer::add(const RepositoryItem::Data &d)
+{
+    using F = RepositoryFields;
+    Record r{.type = Type::Repository};
+    r.flags = (d.has_issues ? F::HasIssues : 0)
+              | (d.has_discussions ? F::HasDiscussions : 0)
+              | (d.has_wiki ? F::HasWiki : 0)
+              | (d.archived ? F::Archived : 0)
+              | (d.fork ? F::Fork : 0);
+    r.numbers[F::Stars] = d.stargazers_count;
+    r.numbers[F::Forks] = d.forks_count;
+    r.numbers[F::OpenIssues] = d.open_issues_count;
+    r.strings[F::FullName] = string(d.full_name);
+    r.strings[F::Description] = string(d.description);
+    r.strings[F::HtmlUrl] = string(d.html_url);
+    r.strings[F::AvatarUrl] = string(d.avatar_url);
+    r.strings[F::Language] = string(d.language);
+    r.strings[F::UpdatedAt] = string(d.updated_at);
+    r.strings[F::NodeId] = string(d.node_id);
+    records_.push_back(r);
+    return records_.size() - 1;
+}
+
+size_t ItemStore::Writer::add(const IssueItem::Data &d)
+{
+    using F = IssueFields;
+    Record r{.type = Type::Issue};
+    r.flags = d.pull_request ? F::PullRequest : 0;
+    r.numbers[F::Number] = d.number;
+    for (size_t i = 0; i < d.reactions.size(); ++i)
+        r.numbers[F::Reactions + i] = d.reactions[i];
+    r.strings[F::Repository] = string(d.repository);
+    r.strings[F::Title] = string(d.title);
+    r.strings[F::State] = string(d.state);
+    r.strings[F::HtmlUrl] = string(d.html_url);
+    r.strings[F::AvatarUrl] = string(d.avatar_url);
+    r.strings[F::Labels] = string(d.labels.join(QChar::LineFeed));
+    r.strings[F::UpdatedAt] = string(d.updated_at);
+    r.strings[F::NodeId] = string(d.node_id);
+    records_.push_back(r);
+    return records_.size() - 1;
+}
+
+void ItemStore::Writer::setCounter(size_t record, size_t counter, qint64 value)
+{ records_[record].counters[counter] = value; }
+
+void ItemStore::Writer::setMeta(const QStringList &meta) { meta_ = meta.mid(0, 4); }
+
+bool ItemStore::Writer::write(const QString &path) const
+{
+    // The pool is not interned for meta, it changes with every write
+    QString pool = pool_;
+    Header header{.version = version,
+                  .record_size = sizeof(Record),
+                  .record_count = static_cast<quint32>(records_.size())};
+    memcpy(header.magic, magic, sizeof(magic));
+    for (qsizetype i = 0; i < meta_.size(); ++i)
+    {
+        header.meta[i] = {static_cast<quint32>(pool.size()), static_cast<quint32>(meta_[i].size())};
+        pool.append(meta_[i]);
+    }
+    header.string_pool_size = static_cast<quint32>(pool.size());
+
+    if (!QDir().mkpath(QFileInfo(path).path()))
+    {
+        WARN << "Failed to create directory:" << QFileInfo(path).path();
+        return false;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        WARN << "Failed to write item store:" << file.errorString();
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(records_.data()), records_.size() * sizeof(Record));
+    file.write(reinterpret_cast<const char*>(pool.utf16()), pool.size() * sizeof(char16_t));
+
+    if (!file.commit())
+    {
+        WARN << "Failed to write item store:" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+shared_ptr<const ItemStore> ItemStore::open(const QString &path)
+{
+    auto file = make_unique<QFile>(path);
+    if (!file->exists())
+        return {};
+    else if (!file->open(QIODevice::ReadOnly))
+    {
+        WARN << "Failed to open item store:" << file->errorString();
+        return {};
+    }
+
+    const auto size = static_cast<size_t>(file->size());
+    if (size < sizeof(Header))
+    {
+        WARN << "Invalid item store:" << path;
+        return {};
+    }
+
+    const auto *data = file->map(0, file->size());
+    if (!data)
+    {
+        WARN << "Failed to map item store:" << file->errorString();
+        return {};
+    }
+
+    const auto *header = reinterpret_cast<const Header*>(data);
+    if (memcmp(header->magic, magic, sizeof(magic)) != 0
+        || header->version != version
+        || header->record_size != sizeof(Record)
+        || size != sizeof(Header)
+                       + header->record_count * sizeof(Record)
+                       + header->string_pool_size * sizeof(char16_t))
+    {
+        INFO << "Discarding incompatible item store:" << path;
+        return {};
+    }
+
+    shared_ptr<ItemStore> store(new ItemStore);
+    store->header_ = header;
+    store->records_ = reinterpret_cast<const Record*>(data + sizeof(Header));
+    store->pool_ = reinterpret_cast<const char16_t*>(data + sizeof(Header)
+                                                     + header->record_count * sizeof(Record));
+    store->file_ = ::move(file);
+    return store;
+}
+
+ItemStore::~ItemStore() = default;  // QFile unmaps on destruction
+
+size_t ItemStore::size() const { return header_->record_count; }
+
+ItemStore::Type ItemStore::type(size_t record) const { return records_[record].type; }
+
+quint8 ItemStore::flags(size_t record) const { return records_[record].flags; }
+
+qint64 ItemStore::number(size_t record, size_t field) const
+{ return records_[record].numbers[field]; }
+
+qint64 ItemStore::counter(size_t record, size_t counter) const
+{ return records_[record].counters[counter]; }
+
+QString ItemStore::view(const StringRef &ref) const
+{
+    if (ref.offset + ref.size > header_->string_pool_size)
+        return {};
+    return QString::fromRawData(reinterpret_cast<const QChar*>(pool_ + ref.offset), ref.size);
+}
+
+QString ItemStore::string(size_t record, size_t field) const
+{ return view(records_[record].strings[field]); }
+
+// Deep copies, materialized items must not depend on the lifetime of the store
+
+static QString copy(const QString &view) { return QString(view.constData(), view.size()); }
+
+QString ItemStore::meta(size_t index) const { return copy(view(header_->meta[index])); }
+
+UserItem::Data ItemStore::userData(size_t i) const
+{
+    using F = UserFields;
+    return {
+        .login = copy(string(i, F::Login)),
+        .type = copy(string(i, F::Type)),
+        .html_url = copy(string(i, F::HtmlUrl)),
+        .avatar_url = copy(string(i, F::AvatarUrl)),
+        .name = copy(string(i, F::Name))
+    };
+}
+
+RepositoryItem::Data ItemStore::repositoryData(size_t i) const
+{
+    using F = RepositoryFields;
+    const auto f = flags(i);
+    return {
+        .node_id = copy(string(i, F::NodeId)),
+        .full_name = copy(string(i, F::FullName)),
+        .description = copy(string(i, F::Description)),
+        .html_url = copy(string(i, F::HtmlUrl)),
+        .avatar_url = copy(string(i, F::AvatarUrl)),
+        .language = copy(string(i, F::Language)),
+        .updated_at = copy(string(i, F::UpdatedAt)),
+        .stargazers_count = number(i, F::Stars),
+        .forks_count = number(i, F::Forks),
+        .open_issues_count = number(i, F::OpenIssues),
+        .has_issues = bool(f & F::HasIssues),
+        .has_discussions = bool(f & F::HasDiscussions),
+        .has_wiki = bool(f & F::HasWiki),
+        .archived = bool(f & F::Archived),
+        .fork = bool(f & F::Fork)
+    };
+}
+
+IssueItem::Data ItemStore::issueData(size_t i) const
+{
+    using F = IssueFields;
+    IssueItem::Data d{
+        .repository = copy(string(i, F::Repository)),
+        .node_id = copy(string(i, F::NodeId)),
+        .number = number(i, F::Number),
+        .title = copy(string(i, F::Title)),
+        .state = copy(string(i, F::State)),
+        .html_url = copy(string(i, F::HtmlUrl)),
+        .avatar_url = copy(string(i, F::AvatarUrl)),
+        .updated_at = copy(string(i, F::UpdatedAt)),
+        .labels = string(i, F::Labels).split(QChar::LineFeed, Qt::SkipEmptyParts),
+        .pull_request = bool(flags(i) & F::PullRequest)
+    };
+    for (size_t r = 0; r < d.reactions.size(); ++r)
+        d.reactions[r] = number(i, F::Reactions + r);
+    return d;
+}
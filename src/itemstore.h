@@ -0,0 +1,130 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#pragma once
+#include "items.h"
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <vector>
+class QFile;
+
+namespace github
+{
+
+///
+/// Compact, versioned binary storage of item data.
+///
+/// A file consists of a header, fixed-width records and a UTF-16 string pool, in native byte
+/// order. Files are memory-mapped read-only. Opening parses nothing, strings are views into the
+/// mapping and items are only materialized on demand. Immutable and thread-safe once opened.
+///
+class ItemStore
+{
+public:
+
+    static constexpr quint16 version = 3;
+
+    enum class Type : quint8 { User = 1, Repository = 2, Issue = 3 };
+
+    struct UserFields
+    {
+        enum Str { Login, Type, HtmlUrl, AvatarUrl, Name };
+    };
+
+    struct RepositoryFields
+    {
+        enum Str { FullName, Description, HtmlUrl, AvatarUrl, Language, NodeId, UpdatedAt };
+        enum Num { Stars, Forks, OpenIssues };
+        enum Flag { HasIssues = 1, HasDiscussions = 2, HasWiki = 4, Archived = 8, Fork = 16 };
+    };
+
+    struct IssueFields
+    {
+        enum Str { Repository, Title, State, HtmlUrl, AvatarUrl, Labels, UpdatedAt, NodeId };
+        enum Num { Number, Reactions };  // Reactions spans IssueItem::Reactions
+        enum Flag { PullRequest = 1 };
+    };
+
+    struct StringRef
+    {
+        quint32 offset;  // in UTF-16 code units
+        quint32 size;
+    };
+
+    struct Record
+    {
+        Type type;
+        quint8 flags;
+        quint8 reserved[6];
+        qint64 numbers[9];
+        qint64 counters[2];  // store specific, e.g. usage statistics
+        StringRef strings[8];
+    };
+
+    struct Header
+    {
+        char magic[4];
+        quint16 version;
+        quint16 record_size;
+        quint32 record_count;
+        quint32 string_pool_size;  // in UTF-16 code units
+        StringRef meta[4];         // store specific metadata
+    };
+
+    /// Builds a store file.
+    class Writer
+    {
+    public:
+        /// Adds a record and returns its index.
+        size_t add(const UserItem::Data &);
+        size_t add(const RepositoryItem::Data &);
+        size_t add(const IssueItem::Data &);
+        void setCounter(size_t record, size_t counter, qint64 value);
+        void setMeta(const QStringList &);  // at most four strings
+
+        /// Writes the store atomically.
+        bool write(const QString &path) const;
+
+    private:
+        StringRef string(const QString &);
+        std::vector<Record> records_;
+        QStringList meta_;
+        QString pool_;
+        QHash<QString, StringRef> interned_;
+    };
+
+    /// Maps the store at `path`. Returns nullptr if the file does not exist or is incompatible.
+    static std::shared_ptr<const ItemStore> open(const QString &path);
+
+    ~ItemStore();
+
+    size_t size() const;
+    Type type(size_t record) const;
+    quint8 flags(size_t record) const;
+    qint64 number(size_t record, size_t field) const;
+    qint64 counter(size_t record, size_t counter) const;
+
+    /// Returns a string field without copying. The data is valid as long as the store.
+    QString string(size_t record, size_t field) const;
+
+    /// Returns a copy of the metadata string `index`.
+    QString meta(size_t index) const;
+
+    UserItem::Data userData(size_t record) const;
+    RepositoryItem::Data repositoryData(size_t record) const;
+    IssueItem::Data issueData(size_t record) const;
+
+private:
+
+    ItemStore() = default;
+    QString view(const StringRef &) const;
+
+    std::unique_ptr<QFile> file_;
+    const Header *header_ = nullptr;
+    const Record *records_ = nullptr;
+    const char16_t *pool_ = nullptr;
+
+};
+
+}
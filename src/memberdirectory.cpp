@@ -0,0 +1,236 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "github.h"
+#include "itemstore.h"
+#include "items.h"
+#include "memberdirectory.h"
+#include "scheduler.h"
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+#include <albert/app.h>
+#include <albert/logging.h>
+#include <albert/matcher.h>
+#include <ranges>
+using namespace Qt::StringLiterals;
+using namespace albert;
+using namespace github;
+using namespace std;
+
+namespace
+{
+static const auto sync_interval = 6h;
+static const auto sync_margin = 10min;  // synced_at is stamped after the fetch, the timer is not
+
+enum Meta { SyncedAt };
+
+static const auto members_query = uR"(
+query($org: String!, $cursor: String) {
+  organization(login: $org) {
+    membersWithRole(first: 100, after: $cursor) {
+      pageInfo { hasNextPage endCursor }
+      nodes { login name avatarUrl url }
+    }
+  }
+})"_s;
+
+QString directoryFilePath(const QString &organization)
+{
+    return QDir(App::cacheLocation() / "github" / "members").filePath(organization + u".bin"_s);
+}
+}
+
+MemberDirectory::MemberDirectory(const RestApi &api) : api_(api)
+{
+    sync_timer_.setInterval(sync_interval);
+    connect(&sync_timer_, &QTimer::timeout, this, [this]{ sync(); });
+    connect(&api_.oauth, &OAuth2::stateChanged, this, [this]{
+        if (!organizations_.isEmpty())
+            sync();
+    });
+}
+
+MemberDirectory::~MemberDirectory() = default;
+
+QStringList MemberDirectory::organizations() const { return organizations_; }
+
+void MemberDirectory::setOrganizations(const QStringList &organizations)
+{
+    organizations_.clear();
+    for (const auto &organization : organizations)
+        if (const auto o = organization.trimmed().toLower();
+            !o.isEmpty() && !organizations_.contains(o))
+        {
+            organizations_ << o;
+            load(o);
+        }
+
+    {
+        lock_guard lock(mutex_);
+        erase_if(snapshots_, [this](const auto &s){ return !organizations_.contains(s.first); });
+    }
+
+    if (organizations_.isEmpty())
+        sync_timer_.stop();
+    else
+    {
+        sync_timer_.start();
+        sync();
+    }
+}
+
+vector<shared_ptr<UserItem>> MemberDirectory::match(const QString &text) const
+{
+    if (text.isEmpty())
+        return {};
+
+    vector<shared_ptr<const ItemStore>> snapshots;
+    {
+        lock_guard lock(mutex_);
+        for (const auto &[_, store] : snapshots_)
+            snapshots.emplace_back(store);
+    }
+
+    // Match on the mapped strings, materialize hits only
+    using F = ItemStore::UserFields;
+    vector<pair<shared_ptr<UserItem>, double>> matches;
+    QSet<QString> matched;  // members of several organizations
+    Matcher matcher(text, {.fuzzy = true});
+    for (const auto &store : snapshots)
+        for (size_t i = 0; i < store->size(); ++i)
+        {
+            double score = 0.;
+            if (auto m = matcher.match(store->string(i, F::Login)); m)
+                score = max(score, m.score());
+            if (auto m = matcher.match(store->string(i, F::Name)); m)
+                score = max(score, m.score());
+
+            if (score > 0. && !matched.contains(store->string(i, F::Login)))
+            {
+                auto item = UserItem::fromData(store->userData(i));
+                matched.insert(item->id());
+                matches.emplace_back(::move(item), score);
+            }
+        }
+
+    ranges::stable_sort(matches, greater{}, &pair<shared_ptr<UserItem>, double>::second);
+
+    auto v = matches | views::keys;
+    return {begin(v), end(v)};
+}
+
+QCoro::Task<> MemberDirectory::sync()
+{
+    if (syncing_)
+    {
+        resync_ = true;  // e.g. organizations added meanwhile
+        co_return;
+    }
+    else if (!api_.isAuthorized())  // GraphQL requires auth
+    {
+        DEBG << "Not authorized, skipping member directory sync.";
+        co_return;
+    }
+    syncing_ = true;
+
+    do
+    {
+        resync_ = false;
+        for (const auto &organization : organizations())
+            co_await sync(organization);
+    }
+    while (resync_);  // the synced ones are skipped, see sync_interval
+
+    syncing_ = false;
+}
+
+QCoro::Task<> MemberDirectory::sync(QString organization)
+{
+    {
+        lock_guard lock(mutex_);
+        if (const auto s = snapshots_.find(organization); s != snapshots_.end())
+            if (const auto synced_at = QDateTime::fromString(s->second->meta(SyncedAt),
+                                                             Qt::ISODate);
+                synced_at.secsTo(QDateTime::currentDateTimeUtc())
+                    < chrono::seconds(sync_interval - sync_margin).count())
+                co_return;
+    }
+
+    vector<UserItem::Data> members;
+    for (QString cursor;;)
+    {
+        QJsonObject variables{{u"org"_s, organization}};
+        if (!cursor.isEmpty())
+            variables.insert(u"cursor"_s, cursor);
+
+        const auto var = co_await api_.fetch<QJsonDocument>(
+            [this, variables]{ return api_.graphql(members_query, variables); },
+            RequestScheduler::Priority::Background, &RestApi::parseJson);
+
+        if (holds_alternative<QString>(var))
+        {
+            WARN << "Failed to sync members of" << organization << get<QString>(var);
+            co_return;
+        }
+
+        const auto o = get<QJsonDocument>(var).object();
+        if (const auto errors = o["errors"_L1].toArray(); !errors.isEmpty())
+        {
+            WARN << "Failed to sync members of" << organization
+                 << errors.first()["message"_L1].toString();
+            co_return;
+        }
+
+        const auto connection = o["data"_L1]["organization"_L1]["membersWithRole"_L1];
+        for (const auto &value : connection["nodes"_L1].toArray())
+        {
+            const auto node = value.toObject();
+            members.push_back({.login = node["login"_L1].toString(),
+                               .type = u"User"_s,
+                               .html_url = node["url"_L1].toString(),
+                               .avatar_url = node["avatarUrl"_L1].toString(),
+                               .name = node["name"_L1].toString()});
+        }
+
+        if (const auto page_info = connection["pageInfo"_L1];
+            page_info["hasNextPage"_L1].toBool())
+            cursor = page_info["endCursor"_L1].toString();
+        else
+            break;
+    }
+
+    if (!organizations_.contains(organization))  // removed meanwhile
+        co_return;
+
+    ItemStore::Writer writer;
+    for (const auto &member : members)
+        writer.add(member);
+    writer.setMeta({QDateTime::currentDateTimeUtc().toString(Qt::ISODate)});
+
+    // The file is replaced atomically, mappings of the previous snapshot stay valid
+    if (!writer.write(directoryFilePath(organization)))
+        co_return;
+
+    DEBG << "Synced" << members.size() << "members of" << organization;
+    load(organization);
+}
+
+void MemberDirectory::load(const QString &organization)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    auto store = ItemStore::open(directoryFilePath(organization));
+    if (!store)
+        return;
+
+    DEBG << u"Mapped member directory of %1 (%2 members) in %3 ms"_s
+                .arg(organization).arg(store->size()).arg(timer.elapsed());
+
+    lock_guard lock(mutex_);
+    snapshots_[organization] = ::move(store);
+}
@@ -0,0 +1,56 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#pragma once
+#include <QCoroTask>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+class UserItem;
+namespace github { class RestApi; class ItemStore; }
+
+///
+/// Local directory of the members of configured organizations.
+///
+/// Synchronizes the members (login, name, avatar) in the background using GraphQL and persists
+/// them as memory-mapped ItemStore in the cache location. Requires authorization, private
+/// memberships require the `read:org` scope. match is thread-safe.
+///
+class MemberDirectory : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    MemberDirectory(const github::RestApi &);
+    ~MemberDirectory() override;
+
+    /// The organizations (login, lower case).
+    QStringList organizations() const;
+
+    /// Sets the organizations, loads their members from disk and synchronizes them.
+    void setOrganizations(const QStringList &);
+
+    /// Fuzzy matches the members by login and name. Returns nothing if `text` is empty.
+    std::vector<std::shared_ptr<UserItem>> match(const QString &text) const;
+
+private:
+
+    QCoro::Task<> sync();
+    QCoro::Task<> sync(QString organization);
+    void load(const QString &organization);
+
+    const github::RestApi &api_;
+    QStringList organizations_;  // main thread only
+    QTimer sync_timer_;
+    bool syncing_ = false;
+    bool resync_ = false;  // sync requested while syncing
+
+    // Accessed by query threads
+    mutable std::mutex mutex_;
+    std::map<QString, std::shared_ptr<const github::ItemStore>> snapshots_;
+
+};
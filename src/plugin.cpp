@@ -2,10 +2,12 @@
 
 #include "configwidget.h"
 #include "handlers.h"
+#include "items.h"
 #include "plugin.h"
 #include <QCoreApplication>
 #include <QCoroTask>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QJsonArray>
 #include <QJsonDocument>
@@ -13,12 +15,14 @@
 #include <QNetworkReply>
 #include <QSettings>
 #include <QThread>
+#include <QTimer>
 #include <QtConcurrentRun>
 #include <albert/app.h>
 #include <albert/icon.h>
 #include <albert/logging.h>
 #include <albert/matcher.h>
 #include <albert/networkutil.h>
+#include <albert/notification.h>
 #include <albert/standarditem.h>
 #include <albert/systemutil.h>
 #include <albert/usagescoring.h>
@@ -34,51 +38,83 @@ namespace
 static const auto keychain_service = u"albert.github"_s;
 static const auto keychain_key = u"secrets"_s;
 static const auto ck_saved_searches = "saved_searches"_L1;
+static const auto ck_pinned_repositories = "pinned_repositories"_L1;
+static const auto ck_organizations = "organizations"_L1;
 }
 
-Plugin::Plugin()
+Plugin::Plugin():
+    refresher(api),
+    recent_items(refresher),
+    issue_index(api),
+    member_directory(api),
+    tree_index(api),
+    file_search_handler_(make_unique<FileSearchHandler>(tree_index))
 {
-    search_handlers_.emplace_back(make_unique<UserSearchHandler>(api));
-    search_handlers_.emplace_back(make_unique<RepoSearchHandler>(api));
-    search_handlers_.emplace_back(make_unique<IssueSearchHandler>(api));
+    GitHubItem::setActivationObserver([this](const GitHubItem &item)
+                                      { recent_items.record(item); });
+
+    search_handlers_.emplace_back(make_unique<UserSearchHandler>(api, refresher,
+                                                                 member_directory));
+    search_handlers_.emplace_back(make_unique<RepoSearchHandler>(api, refresher));
+    search_handlers_.emplace_back(make_unique<IssueSearchHandler>(api, refresher, issue_index));
 }
 
-Plugin::~Plugin() = default;
+Plugin::~Plugin() { GitHubItem::setActivationObserver({}); }
 
 void Plugin::initialize()
 {
-    QtConcurrent::run([this] {
-        readSavedSearches();
-        for (const auto &handler : search_handlers_)
-            connect(handler.get(), &GithubSearchHandler::savedSearchesChanged,
-                    this, &Plugin::writeSavedSearches);
-    })
-    .then(this, [this] {
-        auto *job = new QKeychain::ReadPasswordJob(keychain_service, this);  // Deletes itself
-        job->setKey(keychain_key);
-
-        connect(job, &QKeychain::ReadPasswordJob::finished, this, [this, job] {
-            if (job->error())
-                WARN << "Failed to read secrets from keychain:" << job->errorString();
-            else if (auto secrets = job->textData().split(QChar::Tabulation);
-                     secrets.size() != 3)
-                WARN << "Unexpected format of the secrets read from keychain.";
-            else
+    // Settings and secrets are read concurrently, initialized is emitted once both are done.
+    // Everything not needed to answer the first query is deferred until then.
+    auto timer = make_shared<QElapsedTimer>();
+    timer->start();
+
+    const auto deferred = [this, timer]
+    {
+        // Maps the indexes and starts their background sync
+        issue_index.setRepositories(settings()->value(ck_pinned_repositories).toStringList());
+        member_directory.setOrganizations(settings()->value(ck_organizations).toStringList());
+        DEBG << u"Startup: indexes mapped after %1 ms"_s.arg(timer->elapsed());
+
+        QtConcurrent::run([this] {
+            recent_items.load();
+        })
+        .then(this, [timer] {
+            DEBG << u"Startup: recent items loaded after %1 ms"_s.arg(timer->elapsed());
+        });
+
+        // Opens the connection and checks the token ahead of the first query
+        api.warmUp().then([this](bool token_accepted) {
+            if (!token_accepted)
             {
-                api.oauth.setClientId(secrets[0]);
-                api.oauth.setClientSecret(secrets[1]);
-                api.oauth.setTokens(secrets[2]);
-                DEBG << "Successfully read secrets from keychain.";
+                token_notification_ = make_unique<Notification>(
+                    u"GitHub"_s,
+                    tr("The access token has been rejected. Queries are unauthenticated until "
+                       "you authorize again in the settings."));
+                token_notification_->send();
             }
+        });
+    };
 
-            connect(&api.oauth, &OAuth2::clientIdChanged,     this, &Plugin::writeSecrets);
-            connect(&api.oauth, &OAuth2::clientSecretChanged, this, &Plugin::writeSecrets);
-            connect(&api.oauth, &OAuth2::tokensChanged,       this, &Plugin::writeSecrets);
-
+    auto pending = make_shared<int>(2);
+    const auto done = [this, timer, pending, deferred](const char *phase)
+    {
+        DEBG << u"Startup: %1 after %2 ms"_s.arg(QString::fromUtf8(phase)).arg(timer->elapsed());
+        if (--*pending == 0)
+        {
             emit initialized();
-        });
+            INFO << u"Initialized in %1 ms"_s.arg(timer->elapsed());
+            QTimer::singleShot(0, this, deferred);
+        }
+    };
 
-        job->start();
+    QtConcurrent::run([this] {
+        readSavedSearches();
+    })
+    .then(this, [this, done] {
+        for (const auto &handler : search_handlers_)
+            connect(handler.get(), &GithubSearchHandler::savedSearchesChanged,
+                    this, &Plugin::writeSavedSearches);
+        done("settings read");
     })
     .onCanceled(this, [] {
         WARN << "Cancelled plugin initialization.";
@@ -95,6 +131,32 @@ void Plugin::initialize()
     .onFailed(this, [] {
         CRIT << "Unknown exception while initializing plugin.";
     });
+
+    auto *job = new QKeychain::ReadPasswordJob(keychain_service, this);  // Deletes itself
+    job->setKey(keychain_key);
+
+    connect(job, &QKeychain::ReadPasswordJob::finished, this, [this, job, done] {
+        if (job->error())
+            WARN << "Failed to read secrets from keychain:" << job->errorString();
+        else if (auto secrets = job->textData().split(QChar::Tabulation);
+                 secrets.size() != 3)
+            WARN << "Unexpected format of the secrets read from keychain.";
+        else
+        {
+            api.oauth.setClientId(secrets[0]);
+            api.oauth.setClientSecret(secrets[1]);
+            api.oauth.setTokens(secrets[2]);
+            DEBG << "Successfully read secrets from keychain.";
+        }
+
+        connect(&api.oauth, &OAuth2::clientIdChanged,     this, &Plugin::writeSecrets);
+        connect(&api.oauth, &OAuth2::clientSecretChanged, this, &Plugin::writeSecrets);
+        connect(&api.oauth, &OAuth2::tokensChanged,       this, &Plugin::writeSecrets);
+
+        done("secrets read");
+    });
+
+    job->start();
 }
 
 void Plugin::writeSavedSearches()
@@ -165,11 +227,28 @@ void Plugin::writeSecrets()
     job->start();
 }
 
+QStringList Plugin::pinnedRepositories() const { return issue_index.repositories(); }
+
+void Plugin::setPinnedRepositories(const QStringList &repositories)
+{
+    issue_index.setRepositories(repositories);
+    settings()->setValue(ck_pinned_repositories, issue_index.repositories());
+}
+
+QStringList Plugin::organizations() const { return member_directory.organizations(); }
+
+void Plugin::setOrganizations(const QStringList &organizations)
+{
+    member_directory.setOrganizations(organizations);
+    settings()->setValue(ck_organizations, member_directory.organizations());
+}
+
 vector<Extension*> Plugin::extensions()
 {
     vector<Extension*> extensions{this};
     for (const auto &handler : search_handlers_)
         extensions.push_back(handler.get());
+    extensions.push_back(file_search_handler_.get());
     return extensions;
 }
 
@@ -204,15 +283,25 @@ vector<RankItem> Plugin::rankItems(QueryContext &ctx)
                     [=] { App::instance().show(_q + QChar::Space); },
                     false);
 
-                actions.emplace_back(u"github"_s, Plugin::tr("Show on GitHub"), [=] {
-                    openUrl(u"https://github.com/search?q="_s + percentEncoded(q));
-                });
+                if (!q.contains(u"||"_s))  // compound searches do not exist on GitHub
+                    actions.emplace_back(u"github"_s, Plugin::tr("Show on GitHub"), [=] {
+                        openUrl(u"https://github.com/search?q="_s + percentEncoded(q));
+                    });
+
+                auto subtext = _q;
+                if (const auto count = handler->resultCount(q); count)
+                    subtext = u"%1 · %2"_s.arg(Plugin::tr("%n result(s)", nullptr, *count),
+                                               subtext);
 
-                r.emplace_back(StandardItem::make(t, t, ::move(_q),
+                r.emplace_back(StandardItem::make(t, t, ::move(subtext),
                                                   []{ return Icon::image(u":github"_s); },
                                                   ::move(actions)),
                                m);
             }
+
+    auto recent = recent_items.rankItems(ctx);
+    r.insert(r.end(), make_move_iterator(recent.begin()), make_move_iterator(recent.end()));
+
     return r;
 }
 
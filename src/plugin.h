@@ -2,6 +2,11 @@
 
 #pragma once
 #include "github.h"
+#include "issueindex.h"
+#include "memberdirectory.h"
+#include "recentitems.h"
+#include "refresher.h"
+#include "treeindex.h"
 #include <albert/extensionplugin.h>
 #include <albert/oauth.h>
 #include <albert/globalqueryhandler.h>
@@ -9,6 +14,8 @@
 #include <memory>
 #include <vector>
 
+namespace albert { class Notification; }
+class FileSearchHandler;
 class GithubSearchHandler;
 
 
@@ -34,7 +41,20 @@ public:
     void readSavedSearches();
     void writeSecrets();
 
+    QStringList pinnedRepositories() const;
+    void setPinnedRepositories(const QStringList &);
+
+    QStringList organizations() const;
+    void setOrganizations(const QStringList &);
+
     github::RestApi api;
+    ItemRefresher refresher;
+    RecentItems recent_items;
+    IssueIndex issue_index;
+    MemberDirectory member_directory;
+    TreeIndex tree_index;
     std::vector<std::unique_ptr<GithubSearchHandler>> search_handlers_;
+    std::unique_ptr<FileSearchHandler> file_search_handler_;
+    std::unique_ptr<albert::Notification> token_notification_;
 
 };
@@ -0,0 +1,171 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "items.h"
+#include "itemstore.h"
+#include "recentitems.h"
+#include "refresher.h"
+#include <QDateTime>
+#include <QDir>
+#include <albert/app.h>
+#include <albert/logging.h>
+#include <albert/matcher.h>
+#include <algorithm>
+#include <cmath>
+#include <optional>
+using namespace Qt::StringLiterals;
+using namespace albert;
+using namespace github;
+using namespace std;
+
+namespace
+{
+static const size_t max_entries = 200;
+static const double half_life = 7 * 24 * 3600;  // seconds
+enum Counter { Count, LastUsed };
+
+QString storeFilePath() { return QDir(App::cacheLocation() / "github").filePath(u"recent.bin"_s); }
+
+// Exponentially decaying use count
+double frecency(qint64 count, qint64 last_used, qint64 now)
+{ return count * exp2(-max<qint64>(now - last_used, 0) / half_life); }
+
+// Returns the shared live item, see fromData
+shared_ptr<GitHubItem> share(const GitHubItem &item)
+{
+    if (auto *u = dynamic_cast<const UserItem*>(&item); u)
+        return UserItem::fromData(u->data());
+    else if (auto *r = dynamic_cast<const RepositoryItem*>(&item); r)
+        return RepositoryItem::fromData(r->data());
+    else if (auto *i = dynamic_cast<const IssueItem*>(&item); i)
+        return IssueItem::fromData(i->data());
+    return {};
+}
+}
+
+RecentItems::RecentItems(ItemRefresher &refresher) : refresher_(refresher) {}
+
+void RecentItems::load()
+{
+    const auto store = ItemStore::open(storeFilePath());
+    if (!store)
+        return;
+
+    vector<Entry> entries;
+    for (size_t i = 0; i < store->size(); ++i)
+    {
+        shared_ptr<GitHubItem> item;
+        switch (store->type(i))
+        {
+        case ItemStore::Type::User:
+            item = UserItem::fromData(store->userData(i));
+            break;
+        case ItemStore::Type::Repository:
+            item = RepositoryItem::fromData(store->repositoryData(i));
+            break;
+        case ItemStore::Type::Issue:
+            item = IssueItem::fromData(store->issueData(i));
+            break;
+        }
+        if (item)
+            entries.push_back({::move(item),
+                               store->counter(i, Count),
+                               store->counter(i, LastUsed)});
+    }
+
+    vector<shared_ptr<GitHubItem>> items;
+    for (const auto &entry : entries)
+        items.emplace_back(entry.item);
+    refresher_.track(items);
+
+    DEBG << "Loaded" << entries.size() << "recent items";
+    lock_guard lock(mutex_);
+    entries_ = ::move(entries);
+}
+
+void RecentItems::record(const GitHubItem &item)
+{
+    {
+        lock_guard lock(mutex_);
+
+        Entry entry{.count = 1, .last_used = QDateTime::currentSecsSinceEpoch()};
+        if (auto it = ranges::find(entries_, item.id(), [](const auto &e){ return e.item->id(); });
+            it != entries_.end())
+        {
+            entry.item = it->item;
+            entry.count += it->count;
+            entries_.erase(it);
+        }
+        else if (entry.item = share(item); entry.item)
+            refresher_.track({entry.item});
+        else
+            return;
+
+        entries_.insert(entries_.begin(), ::move(entry));
+        if (entries_.size() > max_entries)
+        {
+            // Evict the least frecent, except the one just used
+            const auto now = QDateTime::currentSecsSinceEpoch();
+            entries_.erase(min_element(entries_.begin() + 1, entries_.end(),
+                                       [now](const auto &a, const auto &b) {
+                                           return frecency(a.count, a.last_used, now)
+                                                  < frecency(b.count, b.last_used, now);
+                                       }));
+        }
+    }
+    save();
+}
+
+vector<RankItem> RecentItems::rankItems(const QString &query) const
+{
+    vector<Entry> entries;
+    {
+        lock_guard lock(mutex_);
+        entries = entries_;
+    }
+
+    const auto now = QDateTime::currentSecsSinceEpoch();
+    double max_frecency = 0.;
+    for (const auto &e : entries)
+        max_frecency = max(max_frecency, frecency(e.count, e.last_used, now));
+
+    vector<RankItem> r;
+    Matcher matcher(query, {.fuzzy = true});
+    for (const auto &e : entries)
+    {
+        optional<double> score;
+        for (const auto &text : {e.item->text(), e.item->id()})
+            if (auto m = matcher.match(text); m)
+                score = max(score.value_or(0.), m.score());
+
+        if (score)
+        {
+            // Usage lifts everyday items, the match dominates
+            const auto usage = frecency(e.count, e.last_used, now) / max_frecency;
+            r.emplace_back(e.item, query.isEmpty() ? usage : *score * (0.75 + 0.25 * usage));
+        }
+    }
+    return r;
+}
+
+void RecentItems::save() const
+{
+    ItemStore::Writer writer;
+    {
+        lock_guard lock(mutex_);
+        for (const auto &e : entries_)
+        {
+            size_t i;
+            if (auto *u = dynamic_cast<const UserItem*>(e.item.get()); u)
+                i = writer.add(u->data());
+            else if (auto *rp = dynamic_cast<const RepositoryItem*>(e.item.get()); rp)
+                i = writer.add(rp->data());
+            else if (auto *is = dynamic_cast<const IssueItem*>(e.item.get()); is)
+                i = writer.add(is->data());
+            else
+                continue;
+            writer.setCounter(i, Count, e.count);
+            writer.setCounter(i, LastUsed, e.last_used);
+        }
+    }
+    writer.write(storeFilePath());
+}
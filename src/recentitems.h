@@ -0,0 +1,50 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#pragma once
+#include <QString>
+#include <albert/rankitem.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+class GitHubItem;
+class ItemRefresher;
+namespace albert { class QueryContext; }
+
+///
+/// Bounded store of the recently used items.
+///
+/// Records activated items with their use count and last use and matches them locally,
+/// ranked by match score and frecency. Persisted as ItemStore in the cache location.
+/// record is main thread only, rankItems is thread-safe.
+///
+class RecentItems
+{
+public:
+
+    RecentItems(ItemRefresher &);
+
+    /// Loads the store from disk.
+    void load();
+
+    /// Records a use of `item` and persists the store.
+    void record(const GitHubItem &item);
+
+    /// Returns the recent items matching `query` ranked by match score and frecency.
+    std::vector<albert::RankItem> rankItems(const QString &query) const;
+
+private:
+
+    struct Entry
+    {
+        std::shared_ptr<GitHubItem> item;
+        qint64 count;
+        qint64 last_used;  // seconds since epoch
+    };
+
+    void save() const;
+
+    ItemRefresher &refresher_;
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;  // most recently used first
+
+};
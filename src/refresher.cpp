@@ -0,0 +1,176 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "github.h"
+#include "items.h"
+#include "refresher.h"
+#include "scheduler.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <albert/logging.h>
+#include <algorithm>
+#include <map>
+using namespace Qt::StringLiterals;
+using namespace albert;
+using namespace github;
+using namespace std;
+using namespace std::chrono;
+
+namespace
+{
+static const auto refresh_interval = 1min;
+static const auto stale_after = 5min;
+static const size_t batch_size = 100;  // GraphQL nodes limit
+static const size_t max_entries = 1000;
+
+// https://docs.github.com/en/graphql/reference/queries#nodes
+static const auto issue_fields =
+    u"title state updatedAt labels(first: 100) { nodes { name } } "
+    u"reactionGroups { content reactors { totalCount } }"_s;
+static const auto nodes_query =
+    u"query($ids: [ID!]!) { nodes(ids: $ids) { id "
+    u"... on Repository { description updatedAt stargazerCount forkCount isArchived "
+    u"hasIssuesEnabled hasDiscussionsEnabled hasWikiEnabled primaryLanguage { name } "
+    u"issues(states: OPEN) { totalCount } pullRequests(states: OPEN) { totalCount } } "
+    u"... on Issue { "_s + issue_fields + u" } "_s
+    u"... on PullRequest { "_s + issue_fields + u" } } }"_s;
+
+// GraphQL ReactionContent in the order of IssueItem::Reactions
+static const array<QLatin1String, 8> reaction_contents{{"THUMBS_UP"_L1, "THUMBS_DOWN"_L1,
+                                                        "LAUGH"_L1, "HOORAY"_L1, "CONFUSED"_L1,
+                                                        "HEART"_L1, "ROCKET"_L1, "EYES"_L1}};
+
+void update(RepositoryItem &item, const QJsonObject &node)
+{
+    auto d = item.data();
+    d.description = node["description"_L1].toString();
+    d.language = node["primaryLanguage"_L1]["name"_L1].toString();
+    d.updated_at = node["updatedAt"_L1].toString();
+    d.stargazers_count = node["stargazerCount"_L1].toInteger();
+    d.forks_count = node["forkCount"_L1].toInteger();
+    d.open_issues_count = node["issues"_L1]["totalCount"_L1].toInteger()  // REST semantics
+                          + node["pullRequests"_L1]["totalCount"_L1].toInteger();
+    d.has_issues = node["hasIssuesEnabled"_L1].toBool();
+    d.has_discussions = node["hasDiscussionsEnabled"_L1].toBool();
+    d.has_wiki = node["hasWikiEnabled"_L1].toBool();
+    d.archived = node["isArchived"_L1].toBool();
+    item.setData(d);
+}
+
+void update(IssueItem &item, const QJsonObject &node)
+{
+    auto d = item.data();
+    d.title = node["title"_L1].toString();
+    d.state = node["state"_L1].toString() == "OPEN"_L1 ? u"open"_s : u"closed"_s;  // or MERGED
+    d.updated_at = node["updatedAt"_L1].toString();
+
+    d.labels.clear();
+    for (const auto &label : node["labels"_L1]["nodes"_L1].toArray())
+        d.labels << label.toObject()["name"_L1].toString();
+
+    d.reactions = {};
+    for (const auto &group : node["reactionGroups"_L1].toArray())
+    {
+        const auto o = group.toObject();
+        if (const auto it = ranges::find(reaction_contents, o["content"_L1].toString());
+            it != reaction_contents.end())
+            d.reactions[distance(reaction_contents.begin(), it)]
+                = o["reactors"_L1]["totalCount"_L1].toInteger();
+    }
+
+    item.setData(d);
+}
+}
+
+ItemRefresher::ItemRefresher(const RestApi &api) : api_(api)
+{
+    timer_.setInterval(refresh_interval);
+    connect(&timer_, &QTimer::timeout, this, [this]{ refresh(); });
+    timer_.start();
+}
+
+ItemRefresher::~ItemRefresher() = default;
+
+void ItemRefresher::track(const vector<shared_ptr<GitHubItem>> &items)
+{
+    const auto now = steady_clock::now();
+    lock_guard lock(mutex_);
+    for (const auto &item : items)
+        if (auto node_id = item->nodeId(); !node_id.isEmpty())
+            entries_.insert_or_assign(::move(node_id), Entry{item, now, now});
+
+    if (entries_.size() > max_entries)
+    {
+        erase_if(entries_, [](const auto &e){ return e.second.item.expired(); });
+        if (entries_.size() > max_entries)  // evict the least recently tracked
+        {
+            vector<steady_clock::time_point> tracked;
+            tracked.reserve(entries_.size());
+            for (const auto &[node_id, entry] : entries_)
+                tracked.push_back(entry.tracked);
+            const auto cutoff = tracked.begin() + (tracked.size() - max_entries);
+            ranges::nth_element(tracked, cutoff);
+            erase_if(entries_, [&](const auto &e){ return e.second.tracked < *cutoff; });
+        }
+    }
+}
+
+QCoro::Task<> ItemRefresher::refresh()
+{
+    if (refreshing_ || !api_.isAuthorized())  // GraphQL requires auth
+        co_return;
+    refreshing_ = true;
+
+    // Collect the stale live items by node id
+    map<QString, shared_ptr<GitHubItem>> stale;
+    {
+        const auto now = steady_clock::now();
+        lock_guard lock(mutex_);
+        erase_if(entries_, [](const auto &e){ return e.second.item.expired(); });
+        for (auto &[node_id, entry] : entries_)
+            if (now - entry.updated > stale_after)
+                if (auto item = entry.item.lock(); item)
+                {
+                    stale.emplace(node_id, ::move(item));
+                    entry.updated = now;
+                }
+    }
+
+    for (auto it = stale.begin(); it != stale.end();)
+    {
+        QJsonArray ids;
+        for (; it != stale.end() && (size_t)ids.size() < batch_size; ++it)
+            ids.append(it->first);
+
+        const auto var = co_await api_.fetch<QJsonDocument>(
+            [this, ids]{ return api_.graphql(nodes_query, {{u"ids"_s, ids}}); },
+            RequestScheduler::Priority::Background, &RestApi::parseJson);
+
+        if (holds_alternative<QString>(var))
+        {
+            WARN << "Failed to refresh items:" << get<QString>(var);
+            break;
+        }
+
+        const auto o = get<QJsonDocument>(var).object();
+        if (const auto errors = o["errors"_L1].toArray(); !errors.isEmpty())
+            DEBG << "GraphQL errors:" << errors.first()["message"_L1].toString();
+
+        uint updated = 0;
+        for (const auto &value : o["data"_L1]["nodes"_L1].toArray())
+        {
+            const auto node = value.toObject();  // null for deleted or inaccessible nodes
+            if (const auto s = stale.find(node["id"_L1].toString()); s != stale.end())
+            {
+                if (auto *r = dynamic_cast<RepositoryItem*>(s->second.get()); r)
+                    update(*r, node);
+                else if (auto *i = dynamic_cast<IssueItem*>(s->second.get()); i)
+                    update(*i, node);
+                ++updated;
+            }
+        }
+        DEBG << "Refreshed" << updated << "items of" << ids.size() << "nodes";
+    }
+
+    refreshing_ = false;
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#pragma once
+#include <QCoroTask>
+#include <QObject>
+#include <QTimer>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+class GitHubItem;
+namespace github { class RestApi; }
+
+///
+/// Keeps the data of live items fresh without spending search requests.
+///
+/// Periodically updates the tracked items that are older than a threshold using batched GraphQL
+/// `nodes` queries, one request per 100 items. Items are held weakly, i.e. only items still shown
+/// or recently used are refreshed. Changes are pushed into the items, which notify observers.
+///
+class ItemRefresher : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    ItemRefresher(const github::RestApi &);
+    ~ItemRefresher() override;
+
+    /// Tracks `items` that have a node id. Items tracked already are marked fresh. Thread-safe.
+    void track(const std::vector<std::shared_ptr<GitHubItem>> &items);
+
+private:
+
+    QCoro::Task<> refresh();
+
+    struct Entry
+    {
+        std::weak_ptr<GitHubItem> item;
+        std::chrono::steady_clock::time_point tracked;  // last, for the eviction
+        std::chrono::steady_clock::time_point updated;
+    };
+
+    const github::RestApi &api_;
+    QTimer timer_;
+    bool refreshing_ = false;
+    std::mutex mutex_;
+    std::map<QString, Entry> entries_;  // by node id
+
+};
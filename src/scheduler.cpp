@@ -0,0 +1,118 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "scheduler.h"
+#include <algorithm>
+using namespace github;
+using namespace std;
+using namespace std::chrono;
+
+RequestTicket::RequestTicket(RequestScheduler &s, function<bool()> alive) :
+    scheduler_(s),
+    alive_(::move(alive))
+{}
+
+RequestTicket::~RequestTicket()
+{
+    scheduler_.dequeue(this);
+    release();
+}
+
+void RequestTicket::release()
+{
+    if (lock_guard lock(scheduler_.mutex_); holds_slot_)
+    {
+        holds_slot_ = false;
+        --scheduler_.in_flight_;
+    }
+    else
+        return;
+
+    scheduler_.scheduleDispatch();
+}
+
+// -------------------------------------------------------------------------------------------------
+
+RequestScheduler::RequestScheduler(milliseconds delay, uint max_concurrent) :
+    delay_(delay),
+    max_concurrent_(max_concurrent)
+{
+    timer_.setSingleShot(true);
+    connect(&timer_, &QTimer::timeout, this, &RequestScheduler::dispatch);
+}
+
+RequestScheduler::~RequestScheduler() = default;
+
+void RequestScheduler::setDelay(milliseconds delay)
+{
+    {
+        lock_guard lock(mutex_);
+        delay_ = delay;
+    }
+    scheduleDispatch();
+}
+
+unique_ptr<RequestTicket> RequestScheduler::acquire(Priority priority,
+                                                               function<bool()> alive)
+{
+    unique_ptr<RequestTicket> ticket(new RequestTicket(*this, ::move(alive)));
+    {
+        lock_guard lock(mutex_);
+        queues_[static_cast<size_t>(priority)].push_back(ticket.get());
+    }
+    scheduleDispatch();
+    return ticket;
+}
+
+void RequestScheduler::scheduleDispatch()
+{ QMetaObject::invokeMethod(this, &RequestScheduler::dispatch, Qt::QueuedConnection); }
+
+void RequestScheduler::dequeue(RequestTicket *ticket)
+{
+    lock_guard lock(mutex_);
+    for (auto &queue : queues_)
+        erase(queue, ticket);
+}
+
+void RequestScheduler::dispatch()
+{
+    // Granting is posted to the thread of the ticket. Holding the lock ensures the ticket is
+    // alive while posting. Qt discards the posted call if the ticket is deleted before.
+    const auto grant = [](RequestTicket *ticket) {
+        QMetaObject::invokeMethod(ticket, [ticket]{ emit ticket->granted(); },
+                                  Qt::QueuedConnection);
+    };
+
+    lock_guard lock(mutex_);
+
+    // Cancel dead requests
+    for (auto &queue : queues_)
+        erase_if(queue, [&](RequestTicket *t){
+            if (t->alive_ && !t->alive_())
+            {
+                grant(t);  // No slot, the owner bails out
+                return true;
+            }
+            return false;
+        });
+
+    while (in_flight_ < max_concurrent_)
+    {
+        auto queue = ranges::find_if(queues_, [](const auto &q){ return !q.empty(); });
+        if (queue == queues_.end())
+            return;
+
+        if (const auto now = steady_clock::now(); now < next_grant_)
+        {
+            timer_.start(duration_cast<milliseconds>(next_grant_ - now) + 1ms);
+            return;
+        }
+        else
+            next_grant_ = now + delay_;
+
+        auto *ticket = queue->front();
+        queue->pop_front();
+        ticket->holds_slot_ = true;
+        ++in_flight_;
+        grant(ticket);
+    }
+}
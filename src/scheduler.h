@@ -0,0 +1,96 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#pragma once
+#include <QObject>
+#include <QTimer>
+#include <array>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace github
+{
+class RequestScheduler;
+
+/// A request slot granted by RequestScheduler.
+class RequestTicket : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    ~RequestTicket() override;
+
+    /// Releases the slot. Idempotent.
+    void release();
+
+signals:
+
+    void granted();
+
+private:
+
+    RequestTicket(RequestScheduler &, std::function<bool()> alive);
+
+    RequestScheduler &scheduler_;
+    const std::function<bool()> alive_;
+    bool holds_slot_ = false;  // guarded by scheduler mutex
+
+    friend class RequestScheduler;
+};
+
+
+///
+/// Schedules GitHub requests of all handlers in a shared, per user budget.
+///
+/// Grants at most one request per delay and limits the number of requests in flight. Pending
+/// requests are granted by priority class, FIFO within a class. Requests whose owner died are
+/// granted immediately without consuming budget; the owner is expected to check its state.
+///
+/// Thread-safe. Tickets can be acquired from any thread that runs an event loop.
+///
+class RequestScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    enum class Priority {
+        Interactive,  ///< First page of a query
+        Scroll,       ///< Subsequent pages of a query
+        Prefetch,     ///< Speculative requests
+        Background    ///< Synchronization, polling
+    };
+
+    RequestScheduler(std::chrono::milliseconds delay, uint max_concurrent);
+    ~RequestScheduler() override;
+
+    void setDelay(std::chrono::milliseconds delay);
+
+    /// Enqueues a request of `priority`. Await RequestTicket::granted before sending it.
+    /// `alive` is polled to drop requests of dead queries. The returned ticket holds a slot
+    /// until it is released or destroyed.
+    [[nodiscard]] std::unique_ptr<RequestTicket> acquire(Priority priority,
+                                                         std::function<bool()> alive = {});
+
+private:
+
+    void dispatch();
+    void scheduleDispatch();
+    void dequeue(RequestTicket *);
+
+    friend class RequestTicket;
+
+    std::mutex mutex_;
+    std::array<std::deque<RequestTicket*>, 4> queues_;
+    std::chrono::milliseconds delay_;
+    std::chrono::steady_clock::time_point next_grant_;
+    const uint max_concurrent_;
+    uint in_flight_ = 0;
+    QTimer timer_;
+
+};
+
+}
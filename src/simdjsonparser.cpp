@@ -0,0 +1,151 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "items.h"
+#include "simdjsonparser.h"
+#include <QByteArray>
+#include <simdjson.h>
+using namespace Qt::StringLiterals;
+using namespace simdjson;
+using namespace std;
+
+namespace
+{
+
+inline ondemand::parser &threadParser()
+{
+    thread_local ondemand::parser parser;
+    return parser;
+}
+
+inline QString toString(simdjson_result<ondemand::value> v)
+{
+    if (string_view sv; v.get_string().get(sv) == SUCCESS)
+        return QString::fromUtf8(sv.data(), static_cast<qsizetype>(sv.size()));
+    return {};  // missing or null
+}
+
+inline qint64 toInt(simdjson_result<ondemand::value> v)
+{
+    if (int64_t i; v.get_int64().get(i) == SUCCESS)
+        return i;
+    return 0;
+}
+
+inline bool toBool(simdjson_result<ondemand::value> v)
+{
+    if (bool b; v.get_bool().get(b) == SUCCESS)
+        return b;
+    return false;
+}
+
+inline QString avatarUrl(simdjson_result<ondemand::value> v)
+{
+    if (ondemand::object o; v.get_object().get(o) == SUCCESS)
+        return toString(o["avatar_url"]);
+    return {};
+}
+
+template<class T>
+shared_ptr<T> makeItem(ondemand::object &o);
+
+template<>
+shared_ptr<UserItem> makeItem(ondemand::object &o)
+{
+    return UserItem::fromData({
+        .login = toString(o["login"]),
+        .type = toString(o["type"]),
+        .html_url = toString(o["html_url"]),
+        .avatar_url = toString(o["avatar_url"])
+    });
+}
+
+template<>
+shared_ptr<RepositoryItem> makeItem(ondemand::object &o)
+{
+    // Designated initializers evaluate in order. Keeps the lookups close to document order.
+    return RepositoryItem::fromData({
+        .node_id = toString(o["node_id"]),
+        .full_name = toString(o["full_name"]),
+        .description = toString(o["description"]),
+        .html_url = toString(o["html_url"]),
+        .avatar_url = avatarUrl(o["owner"]),
+        .language = toString(o["language"]),
+        .updated_at = toString(o["updated_at"]),
+        .stargazers_count = toInt(o["stargazers_count"]),
+        .forks_count = toInt(o["forks_count"]),
+        .open_issues_count = toInt(o["open_issues_count"]),
+        .has_issues = toBool(o["has_issues"]),
+        .has_discussions = toBool(o["has_discussions"]),
+        .has_wiki = toBool(o["has_wiki"]),
+        .archived = toBool(o["archived"]),
+        .fork = toBool(o["fork"])
+    });
+}
+
+template<>
+shared_ptr<IssueItem> makeItem(ondemand::object &o)
+{
+    IssueItem::Data d{
+        .repository = toString(o["repository_url"]).section(u'/', -2),
+        .node_id = toString(o["node_id"]),
+        .number = toInt(o["number"]),
+        .title = toString(o["title"]),
+        .state = toString(o["state"]),
+        .html_url = toString(o["html_url"]),
+        .avatar_url = avatarUrl(o["user"])
+    };
+
+    if (ondemand::array labels; o["labels"].get_array().get(labels) == SUCCESS)
+        for (auto label : labels)
+            if (ondemand::object l; label.get_object().get(l) == SUCCESS)
+                d.labels << toString(l["name"]);
+
+    if (ondemand::object r; o["reactions"].get_object().get(r) == SUCCESS)
+        for (size_t i = 0; i < IssueItem::reaction_keys.size(); ++i)
+            d.reactions[i] = toInt(r[string_view(IssueItem::reaction_keys[i].data(),
+                                                 IssueItem::reaction_keys[i].size())]);
+
+    d.updated_at = toString(o["updated_at"]);
+    d.pull_request = o["pull_request"].error() == SUCCESS;
+
+    return IssueItem::fromData(d);
+}
+
+}
+
+template<class T>
+variant<SearchPage, QString> github::simd::parseSearchPage(const QByteArray &json)
+{
+    const padded_string padded(json.constData(), static_cast<size_t>(json.size()));
+
+    ondemand::document doc;
+    if (const auto error = threadParser().iterate(padded).get(doc); error)
+        return u"JSON parse error: %1"_s.arg(QString::fromUtf8(error_message(error)));
+
+    SearchPage page;
+    if (int64_t total_count; doc["total_count"].get_int64().get(total_count) == SUCCESS)
+        page.total_count = total_count;
+
+    ondemand::array array;
+    if (const auto error = doc["items"].get_array().get(array); error)
+        return u"JSON parse error: %1"_s.arg(QString::fromUtf8(error_message(error)));
+
+    for (auto element : array)
+    {
+        ondemand::object o;
+        if (const auto error = element.get_object().get(o); error)
+            return u"JSON parse error: %1"_s.arg(QString::fromUtf8(error_message(error)));
+        page.items.emplace_back(makeItem<T>(o));
+    }
+
+    return page;
+}
+
+template variant<SearchPage, QString>
+github::simd::parseSearchPage<UserItem>(const QByteArray &);
+
+template variant<SearchPage, QString>
+github::simd::parseSearchPage<RepositoryItem>(const QByteArray &);
+
+template variant<SearchPage, QString>
+github::simd::parseSearchPage<IssueItem>(const QByteArray &);
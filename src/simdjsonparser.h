@@ -0,0 +1,19 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#pragma once
+#include <QString>
+#include <variant>
+class QByteArray;
+struct SearchPage;
+
+namespace github::simd
+{
+
+/// Parses a search response without building a DOM.
+///
+/// Only the fields used by the item type `T` are extracted. Available if the plugin is built
+/// with ``GITHUB_USE_SIMDJSON``.
+template<class T>
+std::variant<SearchPage, QString> parseSearchPage(const QByteArray &json);
+
+}
@@ -0,0 +1,132 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <albert/logging.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+using namespace Qt::StringLiterals;
+using namespace std;
+
+namespace
+{
+
+// Streams events in the JSON array format. The closing bracket is optional, i.e. the file is
+// valid even if the process does not exit cleanly.
+struct TraceFile
+{
+    QFile file;
+    mutex mtx;
+    const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+    const qint64 pid = QCoreApplication::applicationPid();
+};
+
+TraceFile *traceFile()
+{
+    static const unique_ptr<TraceFile> trace_file = []() -> unique_ptr<TraceFile> {
+        const auto path = qEnvironmentVariable("ALBERT_GITHUB_TRACE");
+        if (path.isEmpty())
+            return {};
+
+        auto f = make_unique<TraceFile>();
+        f->file.setFileName(path);
+        if (!f->file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            WARN << "Failed to open trace file:" << f->file.errorString();
+            return {};
+        }
+        f->file.write("[\n");
+        INFO << "Tracing to" << path;
+        return f;
+    }();
+    return trace_file.get();
+}
+
+}
+
+bool github::trace::enabled() { return traceFile(); }
+
+quint64 github::trace::newId()
+{
+    static atomic<quint64> id = 0;
+    return ++id;
+}
+
+qint64 github::trace::now()
+{
+    if (auto *f = traceFile(); f)
+        return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now()
+                                                           - f->epoch).count();
+    return 0;
+}
+
+namespace
+{
+
+QJsonObject event(const TraceFile &f, const char *name, char phase, quint64 id, qint64 ts,
+                  const QString &detail)
+{
+    QJsonObject e{{u"name"_s, QString::fromUtf8(name)},
+                  {u"cat"_s, u"github"_s},
+                  {u"ph"_s, QString(QLatin1Char(phase))},
+                  {u"id"_s, u"0x%1"_s.arg(id, 0, 16)},
+                  {u"ts"_s, ts},
+                  {u"pid"_s, f.pid},
+                  {u"tid"_s, static_cast<qint64>(id)}};
+    if (!detail.isEmpty())
+        e.insert(u"args"_s, QJsonObject{{u"detail"_s, detail}});
+    return e;
+}
+
+void write(TraceFile &f, std::initializer_list<QJsonObject> events)
+{
+    QByteArray lines;
+    for (const auto &e : events)
+        lines += QJsonDocument(e).toJson(QJsonDocument::Compact) + ",\n";
+
+    lock_guard lock(f.mtx);
+    f.file.write(lines);
+    f.file.flush();
+}
+
+}
+
+void github::trace::complete(const char *name, quint64 id, qint64 begin, qint64 end,
+                             const QString &detail)
+{
+    // Async begin/end pairs, complete events ("X") of one track must not overlap
+    if (auto *f = traceFile(); f)
+        write(*f, {event(*f, name, 'b', id, begin, detail), event(*f, name, 'e', id, end, {})});
+}
+
+void github::trace::instant(const char *name, quint64 id, const QString &detail)
+{
+    if (auto *f = traceFile(); f)
+        write(*f, {event(*f, name, 'n', id, now(), detail)});
+}
+
+github::trace::Span::Span(const char *name, quint64 id, const QString &detail) :
+    name_(name), id_(id)
+{
+    if (enabled())
+    {
+        detail_ = detail;
+        begin_ = now();
+    }
+}
+
+github::trace::Span::~Span() { end(); }
+
+void github::trace::Span::end()
+{
+    if (begin_ >= 0)
+    {
+        complete(name_, id_, begin_, now(), detail_);
+        begin_ = -1;
+    }
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#pragma once
+#include <QString>
+
+///
+/// Opt-in span tracing in the Chrome trace event format.
+///
+/// Enabled if the environment variable ALBERT_GITHUB_TRACE is set to the path of the trace file.
+/// Spans are recorded as async events correlated by id, i.e. the spans of a query, including
+/// concurrent ones, are shown nested on a track of its own in Perfetto or chrome://tracing.
+/// Thread-safe. Costs a branch if disabled.
+///
+namespace github::trace
+{
+
+bool enabled();
+
+/// Returns a new id to correlate the spans of a query.
+quint64 newId();
+
+/// Returns the current time on the trace clock in microseconds.
+qint64 now();
+
+/// Records a span from `begin` to `end` (trace clock).
+void complete(const char *name, quint64 id, qint64 begin, qint64 end, const QString &detail = {});
+
+/// Records an event without duration, e.g. handing items to the frontend.
+void instant(const char *name, quint64 id, const QString &detail = {});
+
+/// Records a span from construction to end() or destruction.
+class Span
+{
+public:
+    Span(const char *name, quint64 id, const QString &detail = {});
+    ~Span();
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+
+    void end();  // idempotent
+
+private:
+    const char *name_;
+    const quint64 id_;
+    QString detail_;
+    qint64 begin_ = -1;  // -1 if disabled or ended
+};
+
+}
@@ -0,0 +1,259 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#include "treeindex.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <albert/app.h>
+#include <albert/logging.h>
+#include <cstring>
+using namespace Qt::StringLiterals;
+using namespace albert;
+using namespace github;
+using namespace std;
+
+namespace
+{
+static const char magic[4] = {'G', 'H', 'P', 'T'};
+static const quint16 version = 1;
+static const auto revalidation_interval = 1min;
+
+QString treeFilePath(const QString &repository)
+{
+    return QDir(App::cacheLocation() / "github" / "trees")
+        .filePath(QString(repository).replace(u'/', u'.') + u".bin"_s);
+}
+
+Expected<QStringList> parseTree(const Response &response)
+{
+    const auto var = RestApi::parseJson(response);
+    if (holds_alternative<QString>(var))
+        return get<QString>(var);
+
+    const auto &doc = get<QJsonDocument>(var);
+    if (doc["truncated"_L1].toBool())  // more than 100k entries or 7 MB
+        WARN << "Repository tree truncated, some files will be missing.";
+
+    QStringList paths;
+    for (const auto &value : doc["tree"_L1].toArray())
+        if (const auto o = value.toObject(); o["type"_L1].toString() == "blob"_L1)
+            paths << o["path"_L1].toString();
+    return paths;
+}
+}
+
+// -------------------------------------------------------------------------------------------------
+
+// File layout: header, path_count + 1 offsets into the pool, UTF-16 pool. Native byte order.
+struct TreeIndex::Tree::Header
+{
+    char magic[4];
+    quint16 version;
+    quint16 reserved;
+    quint32 path_count;
+    quint32 pool_size;  // in UTF-16 code units
+    char16_t sha[40];
+};
+
+bool TreeIndex::Tree::write(const QString &path, const QString &sha, const QStringList &paths)
+{
+    Header header{.version = version, .path_count = static_cast<quint32>(paths.size())};
+    memcpy(header.magic, magic, sizeof(magic));
+    memcpy(header.sha, sha.left(40).leftJustified(40, u'0').utf16(), sizeof(header.sha));
+
+    vector<quint32> offsets{0};
+    offsets.reserve(paths.size() + 1);
+    for (const auto &p : paths)
+        offsets.push_back(offsets.back() + static_cast<quint32>(p.size()));
+    const auto pool = paths.join(QString{});
+    header.pool_size = static_cast<quint32>(pool.size());
+
+    if (!QDir().mkpath(QFileInfo(path).path()))
+    {
+        WARN << "Failed to create directory:" << QFileInfo(path).path();
+        return false;
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        WARN << "Failed to write tree index:" << file.errorString();
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(quint32));
+    file.write(reinterpret_cast<const char*>(pool.utf16()), pool.size() * sizeof(char16_t));
+
+    if (!file.commit())
+    {
+        WARN << "Failed to write tree index:" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+shared_ptr<const TreeIndex::Tree> TreeIndex::Tree::open(const QString &path)
+{
+    auto file = make_unique<QFile>(path);
+    if (!file->exists())
+        return {};
+    else if (!file->open(QIODevice::ReadOnly))
+    {
+        WARN << "Failed to open tree index:" << file->errorString();
+        return {};
+    }
+
+    const auto size = static_cast<size_t>(file->size());
+    if (size < sizeof(Header))
+    {
+        WARN << "Invalid tree index:" << path;
+        return {};
+    }
+
+    const auto *data = file->map(0, file->size());
+    if (!data)
+    {
+        WARN << "Failed to map tree index:" << file->errorString();
+        return {};
+    }
+
+    const auto *header = reinterpret_cast<const Header*>(data);
+    if (memcmp(header->magic, magic, sizeof(magic)) != 0
+        || header->version != version
+        || size != sizeof(Header)
+                       + (header->path_count + 1) * sizeof(quint32)
+                       + header->pool_size * sizeof(char16_t))
+    {
+        INFO << "Discarding incompatible tree index:" << path;
+        return {};
+    }
+
+    shared_ptr<Tree> tree(new Tree);
+    tree->header_ = header;
+    tree->offsets_ = reinterpret_cast<const quint32*>(data + sizeof(Header));
+    tree->pool_ = reinterpret_cast<const char16_t*>(data + sizeof(Header)
+                                                    + (header->path_count + 1) * sizeof(quint32));
+    tree->file_ = ::move(file);
+    return tree;
+}
+
+TreeIndex::Tree::~Tree() = default;  // QFile unmaps on destruction
+
+QString TreeIndex::Tree::sha() const
+{ return QString(reinterpret_cast<const QChar*>(header_->sha), 40); }
+
+size_t TreeIndex::Tree::size() const { return header_->path_count; }
+
+QString TreeIndex::Tree::path(size_t index) const
+{
+    return QString::fromRawData(reinterpret_cast<const QChar*>(pool_ + offsets_[index]),
+                                offsets_[index + 1] - offsets_[index]);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TreeIndex::TreeIndex(const RestApi &api) : api_(api) {}
+
+TreeIndex::Entry &TreeIndex::entry(const QString &repository) const
+{
+    auto it = entries_.find(repository);
+    if (it == entries_.end())
+    {
+        QElapsedTimer timer;
+        timer.start();
+        auto tree = Tree::open(treeFilePath(repository));
+        it = entries_.emplace(repository, Entry{.tree = ::move(tree)}).first;
+        if (it->second.tree)
+            DEBG << u"Mapped tree index of %1 (%2 files) in %3 ms"_s
+                        .arg(repository).arg(it->second.tree->size()).arg(timer.elapsed());
+    }
+    return it->second;
+}
+
+bool TreeIndex::isFresh(const QString &repository) const
+{
+    lock_guard lock(mutex_);
+    const auto &e = entry(repository.toLower());
+    return e.tree && chrono::steady_clock::now() - e.validated < revalidation_interval;
+}
+
+QCoro::Task<Expected<shared_ptr<const TreeIndex::Tree>>>
+TreeIndex::tree(QString repository, function<bool()> alive, quint64 trace_id)
+{
+    repository = repository.toLower();
+
+    shared_ptr<const Tree> tree;
+    QByteArray etag;
+    {
+        lock_guard lock(mutex_);
+        const auto &e = entry(repository);
+        if (e.tree && chrono::steady_clock::now() - e.validated < revalidation_interval)
+            co_return e.tree;
+        tree = e.tree;
+        etag = e.etag;
+    }
+
+    // Revalidate the head. A 304 does not count against the rate limit.
+    auto response = co_await api_.send(
+        [this, repository, etag]{ return api_.commitSha(repository, u"HEAD"_s, etag); },
+        RequestScheduler::Priority::Interactive, alive, trace_id);
+
+    if (!response)
+        co_return u"Cancelled"_s;
+
+    if (response->status == 304)
+    {
+        lock_guard lock(mutex_);
+        entry(repository).validated = chrono::steady_clock::now();
+        co_return tree;
+    }
+    else if (response->error)
+    {
+        const auto error = get<QString>(RestApi::parseJson(*response));
+        if (!tree)
+            co_return error;
+        WARN << "Failed to revalidate tree index of" << repository << error;
+        co_return tree;
+    }
+
+    const auto sha = QString::fromLatin1(response->body.trimmed());
+    const auto new_etag = response->header("ETag");
+
+    if (!tree || tree->sha() != sha)
+    {
+        DEBG << "Fetching tree of" << repository << sha;
+        auto var = co_await api_.fetch<QStringList>(
+            [this, repository, sha]{ return api_.gitTree(repository, sha); },
+            RequestScheduler::Priority::Interactive, &parseTree, alive, trace_id);
+
+        if (holds_alternative<QString>(var))
+        {
+            if (!tree)
+                co_return get<QString>(var);
+            WARN << "Failed to fetch tree of" << repository << get<QString>(var);
+            co_return tree;
+        }
+
+        // The file is replaced atomically, mappings of the previous tree stay valid
+        const auto path = treeFilePath(repository);
+        if (!Tree::write(path, sha, get<QStringList>(var)))
+            co_return u"Failed to write tree index of %1."_s.arg(repository);
+        else if (tree = Tree::open(path); !tree)
+            co_return u"Failed to open tree index of %1."_s.arg(repository);
+
+        DEBG << "Indexed" << tree->size() << "files of" << repository;
+    }
+
+    lock_guard lock(mutex_);
+    auto &e = entry(repository);
+    e.tree = tree;
+    e.etag = new_etag;
+    e.validated = chrono::steady_clock::now();
+    co_return tree;
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2025-2025 Manuel Schneider
+
+#pragma once
+#include "github.h"
+#include <QCoroTask>
+#include <QString>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+class QFile;
+
+///
+/// Local index of the file paths of repository trees.
+///
+/// Fetches the full tree of the head commit of a repository in one recursive git trees request
+/// and persists its paths as memory-mapped path list in the cache location. A cheap conditional
+/// request of the head SHA revalidates an index, the tree is re-fetched only if the head moved.
+/// Thread-safe.
+///
+class TreeIndex
+{
+public:
+
+    /// The paths of the files of a commit. Immutable and thread-safe once opened.
+    class Tree
+    {
+    public:
+        /// Writes `paths` of the commit `sha` atomically.
+        static bool write(const QString &path, const QString &sha, const QStringList &paths);
+
+        /// Maps the tree at `path`. Returns nullptr if the file does not exist or is incompatible.
+        static std::shared_ptr<const Tree> open(const QString &path);
+
+        ~Tree();
+
+        QString sha() const;
+        size_t size() const;
+
+        /// Returns a path without copying. The data is valid as long as the tree.
+        QString path(size_t index) const;
+
+    private:
+        struct Header;
+        Tree() = default;
+        std::unique_ptr<QFile> file_;
+        const Header *header_ = nullptr;
+        const quint32 *offsets_ = nullptr;
+        const char16_t *pool_ = nullptr;
+    };
+
+    TreeIndex(const github::RestApi &);
+
+    /// Returns true if the index of `repository` has been revalidated recently, i.e. tree
+    /// returns without a request.
+    bool isFresh(const QString &repository) const;
+
+    /// Returns the tree of the head of `repository` (owner/repo), revalidated if not fresh.
+    /// Serves a stale tree if revalidation fails.
+    QCoro::Task<github::Expected<std::shared_ptr<const Tree>>>
+    tree(QString repository, std::function<bool()> alive = {}, quint64 trace_id = 0);
+
+private:
+
+    struct Entry
+    {
+        std::shared_ptr<const Tree> tree;
+        QByteArray etag;  // of the head SHA request
+        std::chrono::steady_clock::time_point validated;
+    };
+
+    Entry &entry(const QString &repository) const;  // requires mutex_
+
+    const github::RestApi &api_;
+    mutable std::mutex mutex_;
+    mutable std::map<QString, Entry> entries_;  // lazily loaded from disk
+
+};